@@ -25,6 +25,7 @@ static int64_t ticks;
 static unsigned loops_per_tick;
 
 static intr_handler_func timer_interrupt;
+static intr_handler_func inspect_ticks;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
@@ -43,6 +44,7 @@ timer_init (void) {
 	outb (0x40, count >> 8);
 
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
+	intr_register_int (0x45, 3, INTR_OFF, inspect_ticks, "Inspect Timer Ticks");
 }
 
 /* Calibrates loops_per_tick, used to implement brief delays. */
@@ -135,6 +137,14 @@ timer_interrupt (struct intr_frame *args UNUSED) {
 	thread_wakeup(ticks);
 }
 
+/* Tool for benchmarking user programs. Calling this function via int 0x45.
+ * Output:
+ *   @RAX - Number of timer ticks since the OS booted. */
+static void
+inspect_ticks (struct intr_frame *f) {
+	f->R.rax = ticks;
+}
+
 /* Returns true if LOOPS iterations waits for more than one timer
    tick, otherwise false. */
 static bool
@@ -1,10 +1,13 @@
 #include "filesys/directory.h"
+#include <debug.h>
 #include <stdio.h>
 #include <string.h>
 #include <list.h>
+#include <hash.h>
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* A directory. */
 struct dir {
@@ -19,6 +22,414 @@ struct dir_entry {
 	bool in_use;                        /* In use or free? */
 };
 
+/* Directories with more entry slots than this are looked up through
+ * an in-memory name index.  Smaller ones are cheap enough to scan. */
+#define DIR_INDEX_MIN 32
+
+/* Maximum number of directory name indexes kept in memory. */
+#define DIR_INDEX_MAX 8
+
+/* In-memory name index of a large directory.
+ * Built by scanning the directory once and then kept up to date by
+ * dir_add() and dir_remove(), so that looking up a name does not
+ * read the directory from disk.  Its contents are guarded by the
+ * directory's lock.  An index that is evicted or dropped while a
+ * thread uses it is freed when that thread is done with it. */
+struct dir_index {
+	struct list_elem elem;              /* Element in dir_indexes. */
+	int users;                          /* Threads using the index. */
+	bool dropped;                       /* Off the list, to be freed? */
+	struct inode *inode;                /* Directory, held open. */
+	struct hash names;                  /* In-use entries, by name. */
+	off_t *free_ofs;                    /* Offsets of free slots. */
+	size_t free_cnt;                    /* Number of free slots. */
+	size_t free_cap;                    /* Capacity of FREE_OFS. */
+};
+
+/* One in-use entry in a directory name index. */
+struct dir_name {
+	struct hash_elem elem;              /* Element in dir_index's names. */
+	char name[NAME_MAX + 1];            /* Null terminated file name. */
+	disk_sector_t inode_sector;         /* Sector number of header. */
+	off_t ofs;                          /* Offset of entry in directory. */
+};
+
+/* Directory name indexes, most recently used first.
+ *
+ * Changes to a directory and lookups in it hold the directory's
+ * own lock, from inode_lock_dir(), across their disk I/O.  The
+ * locks below guard only what is shared between directories and
+ * are never held across disk I/O. */
+static struct list dir_indexes;
+
+/* Guards DIR_INDEXES and the USERS and DROPPED members of the
+ * indexes. */
+static struct lock index_lock;
+
+/* Guards the dentry cache. */
+static struct lock dentry_lock;
+
+/* Maximum number of entries in the dentry cache. */
+#define DENTRY_MAX 256
+
+/* A cached result of looking up NAME in the directory whose inode
+ * is in sector PARENT.  A negative entry, with INODE_SECTOR set to
+ * NEG_SECTOR, records that no such name exists. */
+struct dentry {
+	struct hash_elem elem;              /* Element in dentries. */
+	struct list_elem lru_elem;          /* Element in dentry_lru. */
+	disk_sector_t parent;               /* Directory's inode sector. */
+	char name[NAME_MAX + 1];            /* Null terminated file name. */
+	disk_sector_t inode_sector;         /* File's inode sector. */
+};
+
+/* Inode sector of a negative dentry.  Sector 0 never holds a file's
+ * inode. */
+#define NEG_SECTOR 0
+
+/* Dentry cache, keyed by parent sector and name, and its entries
+ * in order of use, most recent first. */
+static struct hash dentries;
+static struct list dentry_lru;
+
+static uint64_t dentry_hash (const struct hash_elem *, void *);
+static bool dentry_less (const struct hash_elem *, const struct hash_elem *,
+		void *);
+
+/* Initializes the directory module. */
+void
+dir_init (void) {
+	list_init (&dir_indexes);
+	list_init (&dentry_lru);
+	lock_init (&index_lock);
+	lock_init (&dentry_lock);
+	if (!hash_init (&dentries, dentry_hash, dentry_less, NULL))
+		PANIC ("dentry cache creation failed");
+}
+
+/* Returns a hash value for dentry E. */
+static uint64_t
+dentry_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct dentry *d = hash_entry (e, struct dentry, elem);
+	return hash_string (d->name) ^ hash_int (d->parent);
+}
+
+/* Returns true if dentry A precedes dentry B. */
+static bool
+dentry_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct dentry *a = hash_entry (a_, struct dentry, elem);
+	const struct dentry *b = hash_entry (b_, struct dentry, elem);
+	if (a->parent != b->parent)
+		return a->parent < b->parent;
+	return strcmp (a->name, b->name) < 0;
+}
+
+/* Returns the cached dentry for NAME in directory PARENT, or a
+ * null pointer if there is none.  The caller must hold
+ * dentry_lock, as for all the dentry functions. */
+static struct dentry *
+dentry_find (disk_sector_t parent, const char *name) {
+	struct dentry key;
+	struct hash_elem *e;
+
+	if (strlen (name) > NAME_MAX)
+		return NULL;
+	key.parent = parent;
+	strlcpy (key.name, name, sizeof key.name);
+	e = hash_find (&dentries, &key.elem);
+	return e != NULL ? hash_entry (e, struct dentry, elem) : NULL;
+}
+
+/* Removes dentry D from the cache and frees it. */
+static void
+dentry_free (struct dentry *d) {
+	hash_delete (&dentries, &d->elem);
+	list_remove (&d->lru_elem);
+	free (d);
+}
+
+/* Caches that NAME in directory PARENT resolves to INODE_SECTOR,
+ * or to nothing if INODE_SECTOR is NEG_SECTOR.  Caching is best
+ * effort: nothing is cached if memory is exhausted. */
+static void
+dentry_insert (disk_sector_t parent, const char *name,
+		disk_sector_t inode_sector) {
+	struct dentry *d;
+
+	if (strlen (name) > NAME_MAX)
+		return;
+	if (hash_size (&dentries) >= DENTRY_MAX)
+		dentry_free (list_entry (list_back (&dentry_lru), struct dentry,
+					lru_elem));
+	d = malloc (sizeof *d);
+	if (d == NULL)
+		return;
+	d->parent = parent;
+	strlcpy (d->name, name, sizeof d->name);
+	d->inode_sector = inode_sector;
+	hash_insert (&dentries, &d->elem);
+	list_push_front (&dentry_lru, &d->lru_elem);
+}
+
+/* Drops the cached dentry for NAME in directory PARENT, if any. */
+static void
+dentry_invalidate (disk_sector_t parent, const char *name) {
+	struct dentry *d = dentry_find (parent, name);
+	if (d != NULL)
+		dentry_free (d);
+}
+
+/* Drops every cached dentry within directory PARENT. */
+static void
+dentry_invalidate_dir (disk_sector_t parent) {
+	struct list_elem *e, *next;
+
+	for (e = list_begin (&dentry_lru); e != list_end (&dentry_lru); e = next) {
+		struct dentry *d = list_entry (e, struct dentry, lru_elem);
+		next = list_next (e);
+		if (d->parent == parent)
+			dentry_free (d);
+	}
+}
+
+/* Returns a hash value for dir_name E. */
+static uint64_t
+dir_name_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_string (hash_entry (e, struct dir_name, elem)->name);
+}
+
+/* Returns true if dir_name A precedes dir_name B. */
+static bool
+dir_name_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return strcmp (hash_entry (a, struct dir_name, elem)->name,
+			hash_entry (b, struct dir_name, elem)->name) < 0;
+}
+
+/* Frees dir_name E. */
+static void
+dir_name_free (struct hash_elem *e, void *aux UNUSED) {
+	free (hash_entry (e, struct dir_name, elem));
+}
+
+/* Adds the entry at OFS named NAME for INODE_SECTOR to INDEX.
+ * Returns false if memory is exhausted. */
+static bool
+index_add (struct dir_index *index, const char *name,
+		disk_sector_t inode_sector, off_t ofs) {
+	struct dir_name *n = malloc (sizeof *n);
+	if (n == NULL)
+		return false;
+	strlcpy (n->name, name, sizeof n->name);
+	n->inode_sector = inode_sector;
+	n->ofs = ofs;
+	hash_insert (&index->names, &n->elem);
+	return true;
+}
+
+/* Records that the slot at OFS is free in INDEX.
+ * Returns false if memory is exhausted. */
+static bool
+index_add_free (struct dir_index *index, off_t ofs) {
+	if (index->free_cnt == index->free_cap) {
+		size_t cap = index->free_cap > 0 ? index->free_cap * 2 : 16;
+		off_t *free_ofs = realloc (index->free_ofs, cap * sizeof *free_ofs);
+		if (free_ofs == NULL)
+			return false;
+		index->free_ofs = free_ofs;
+		index->free_cap = cap;
+	}
+	index->free_ofs[index->free_cnt++] = ofs;
+	return true;
+}
+
+/* Returns the entry for NAME in INDEX, or a null pointer if there
+ * is none. */
+static struct dir_name *
+index_find (struct dir_index *index, const char *name) {
+	struct dir_name key;
+	struct hash_elem *e;
+
+	strlcpy (key.name, name, sizeof key.name);
+	e = hash_find (&index->names, &key.elem);
+	return e != NULL ? hash_entry (e, struct dir_name, elem) : NULL;
+}
+
+/* Frees INDEX, which is not on the list of indexes. */
+static void
+index_free (struct dir_index *index) {
+	hash_destroy (&index->names, dir_name_free);
+	inode_close (index->inode);
+	free (index->free_ofs);
+	free (index);
+}
+
+/* Takes INDEX off the list of indexes, if it is still there.
+ * Returns true if no thread uses INDEX, in which case the caller
+ * must free it once it releases index_lock. */
+static bool
+index_unlist (struct dir_index *index) {
+	ASSERT (lock_held_by_current_thread (&index_lock));
+
+	if (!index->dropped) {
+		list_remove (&index->elem);
+		index->dropped = true;
+	}
+	return index->users == 0;
+}
+
+/* Releases INDEX, obtained from index_get(), freeing it if it was
+ * dropped meanwhile. */
+static void
+index_put (struct dir_index *index) {
+	bool dead;
+
+	lock_acquire (&index_lock);
+	dead = --index->users == 0 && index->dropped;
+	lock_release (&index_lock);
+	if (dead)
+		index_free (index);
+}
+
+/* Drops INDEX, which has gone out of step with its directory.  It
+ * is freed by the index_put() that releases it. */
+static void
+index_discard (struct dir_index *index) {
+	lock_acquire (&index_lock);
+	index_unlist (index);
+	lock_release (&index_lock);
+}
+
+/* Builds and returns a name index for the directory in INODE by
+ * reading all of its entries.  The index is not yet on the list of
+ * indexes.  Returns a null pointer if memory is exhausted. */
+static struct dir_index *
+index_build (struct inode *inode) {
+	enum { BATCH = 32 };
+	struct dir_index *index;
+	struct dir_entry *entries;
+	off_t ofs = 0, length = inode_length (inode);
+
+	index = calloc (1, sizeof *index);
+	entries = malloc (BATCH * sizeof *entries);
+	if (index == NULL || entries == NULL
+			|| !hash_init (&index->names, dir_name_hash, dir_name_less, NULL)) {
+		free (entries);
+		free (index);
+		return NULL;
+	}
+	index->users = 1;
+	index->inode = inode_reopen (inode);
+
+	while (ofs + (off_t) sizeof *entries <= length) {
+		off_t bytes = inode_read_at (inode, entries, BATCH * sizeof *entries, ofs);
+		size_t i, cnt = bytes / sizeof *entries;
+		bool ok = true;
+
+		if (cnt == 0)
+			break;
+		for (i = 0; i < cnt && ok; i++, ofs += sizeof *entries)
+			ok = (entries[i].in_use
+					? index_add (index, entries[i].name,
+						entries[i].inode_sector, ofs)
+					: index_add_free (index, ofs));
+		if (!ok) {
+			index_free (index);
+			index = NULL;
+			break;
+		}
+	}
+	free (entries);
+	return index;
+}
+
+/* Returns the name index for DIR, building it if DIR is large
+ * enough to need one, or a null pointer if DIR should be scanned
+ * linearly instead.  The caller must hold DIR's lock and release
+ * the index with index_put(). */
+static struct dir_index *
+index_get (const struct dir *dir) {
+	disk_sector_t sector = inode_get_inumber (dir->inode);
+	struct dir_index *index, *victim = NULL;
+	struct list_elem *e;
+
+	lock_acquire (&index_lock);
+	for (e = list_begin (&dir_indexes); e != list_end (&dir_indexes);
+			e = list_next (e)) {
+		index = list_entry (e, struct dir_index, elem);
+		if (inode_get_inumber (index->inode) == sector) {
+			list_remove (e);
+			list_push_front (&dir_indexes, e);
+			index->users++;
+			lock_release (&index_lock);
+			return index;
+		}
+	}
+	lock_release (&index_lock);
+
+	/* No other thread can build an index for DIR meanwhile, since
+	 * that takes DIR's lock. */
+	if (inode_length (dir->inode) <= DIR_INDEX_MIN * (off_t) sizeof (struct dir_entry))
+		return NULL;
+	index = index_build (dir->inode);
+	if (index == NULL)
+		return NULL;
+
+	lock_acquire (&index_lock);
+	if (list_size (&dir_indexes) >= DIR_INDEX_MAX) {
+		victim = list_entry (list_back (&dir_indexes), struct dir_index, elem);
+		if (!index_unlist (victim))
+			victim = NULL;
+	}
+	list_push_front (&dir_indexes, &index->elem);
+	lock_release (&index_lock);
+
+	if (victim != NULL)
+		index_free (victim);
+	return index;
+}
+
+/* Drops the name index of the directory in SECTOR, if any. */
+static void
+index_drop (disk_sector_t sector) {
+	struct dir_index *dead = NULL;
+	struct list_elem *e;
+
+	lock_acquire (&index_lock);
+	for (e = list_begin (&dir_indexes); e != list_end (&dir_indexes);
+			e = list_next (e)) {
+		struct dir_index *index = list_entry (e, struct dir_index, elem);
+		if (inode_get_inumber (index->inode) == sector) {
+			if (index_unlist (index))
+				dead = index;
+			break;
+		}
+	}
+	lock_release (&index_lock);
+
+	if (dead != NULL)
+		index_free (dead);
+}
+
+/* Shuts down the directory module, dropping the name indexes so
+ * that the directory inodes they hold open are closed. */
+void
+dir_done (void) {
+	lock_acquire (&index_lock);
+	while (!list_empty (&dir_indexes)) {
+		struct dir_index *index = list_entry (list_front (&dir_indexes),
+				struct dir_index, elem);
+		bool dead = index_unlist (index);
+
+		lock_release (&index_lock);
+		if (dead)
+			index_free (index);
+		lock_acquire (&index_lock);
+	}
+	lock_release (&index_lock);
+}
+
 /* Creates a directory with space for ENTRY_CNT entries in the
  * given SECTOR.  Returns true if successful, false on failure. */
 bool
@@ -75,16 +486,34 @@ dir_get_inode (struct dir *dir) {
  * If successful, returns true, sets *EP to the directory entry
  * if EP is non-null, and sets *OFSP to the byte offset of the
  * directory entry if OFSP is non-null.
- * otherwise, returns false and ignores EP and OFSP. */
+ * otherwise, returns false and ignores EP and OFSP.
+ * The caller must hold DIR's lock. */
 static bool
 lookup (const struct dir *dir, const char *name,
 		struct dir_entry *ep, off_t *ofsp) {
+	struct dir_index *index;
 	struct dir_entry e;
 	size_t ofs;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
+	index = index_get (dir);
+	if (index != NULL) {
+		struct dir_name *n = index_find (index, name);
+		bool found = n != NULL;
+
+		if (found && ep != NULL) {
+			ep->inode_sector = n->inode_sector;
+			strlcpy (ep->name, n->name, sizeof ep->name);
+			ep->in_use = true;
+		}
+		if (found && ofsp != NULL)
+			*ofsp = n->ofs;
+		index_put (index);
+		return found;
+	}
+
 	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 			ofs += sizeof e)
 		if (e.in_use && !strcmp (name, e.name)) {
@@ -104,15 +533,41 @@ lookup (const struct dir *dir, const char *name,
 bool
 dir_lookup (const struct dir *dir, const char *name,
 		struct inode **inode) {
+	disk_sector_t parent, inode_sector = NEG_SECTOR;
 	struct dir_entry e;
+	struct dentry *d;
+	bool cached;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
-	if (lookup (dir, name, &e, NULL))
-		*inode = inode_open (e.inode_sector);
+	/* Consult the dentry cache before the directory itself.  The
+	 * directory's lock keeps the entry from being removed before
+	 * its inode is opened. */
+	inode_lock_dir (dir->inode);
+	parent = inode_get_inumber (dir->inode);
+	lock_acquire (&dentry_lock);
+	d = dentry_find (parent, name);
+	cached = d != NULL;
+	if (cached) {
+		list_remove (&d->lru_elem);
+		list_push_front (&dentry_lru, &d->lru_elem);
+		inode_sector = d->inode_sector;
+	}
+	lock_release (&dentry_lock);
+
+	if (!cached) {
+		inode_sector = lookup (dir, name, &e, NULL) ? e.inode_sector : NEG_SECTOR;
+		lock_acquire (&dentry_lock);
+		dentry_insert (parent, name, inode_sector);
+		lock_release (&dentry_lock);
+	}
+
+	if (inode_sector != NEG_SECTOR)
+		*inode = inode_open (inode_sector);
 	else
 		*inode = NULL;
+	inode_unlock_dir (dir->inode);
 
 	return *inode != NULL;
 }
@@ -125,6 +580,7 @@ dir_lookup (const struct dir *dir, const char *name,
  * error occurs. */
 bool
 dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
+	struct dir_index *index;
 	struct dir_entry e;
 	off_t ofs;
 	bool success = false;
@@ -137,6 +593,7 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 		return false;
 
 	/* Check that NAME is not in use. */
+	inode_lock_dir (dir->inode);
 	if (lookup (dir, name, NULL, NULL))
 		goto done;
 
@@ -146,11 +603,17 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 
 	 * inode_read_at() will only return a short read at end of file.
 	 * Otherwise, we'd need to verify that we didn't get a short
-	 * read due to something intermittent such as low memory. */
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-			ofs += sizeof e)
-		if (!e.in_use)
-			break;
+	 * read due to something intermittent such as low memory.
+	 * An indexed directory knows its free slots already. */
+	index = index_get (dir);
+	if (index != NULL)
+		ofs = (index->free_cnt > 0 ? index->free_ofs[--index->free_cnt]
+				: inode_length (dir->inode));
+	else
+		for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+				ofs += sizeof e)
+			if (!e.in_use)
+				break;
 
 	/* Write slot. */
 	e.in_use = true;
@@ -158,7 +621,22 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	e.inode_sector = inode_sector;
 	success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 
+	/* Keep the index in step with the disk, or drop it, and forget
+	 * any negative dentry for NAME. */
+	lock_acquire (&dentry_lock);
+	dentry_invalidate (inode_get_inumber (dir->inode), name);
+	lock_release (&dentry_lock);
+	if (index != NULL) {
+		if (!(success
+					? index_add (index, name, inode_sector, ofs)
+					: ofs >= inode_length (dir->inode)
+						|| index_add_free (index, ofs)))
+			index_discard (index);
+		index_put (index);
+	}
+
 done:
+	inode_unlock_dir (dir->inode);
 	return success;
 }
 
@@ -167,6 +645,7 @@ done:
  * which occurs only if there is no file with the given NAME. */
 bool
 dir_remove (struct dir *dir, const char *name) {
+	struct dir_index *index;
 	struct dir_entry e;
 	struct inode *inode = NULL;
 	bool success = false;
@@ -176,6 +655,7 @@ dir_remove (struct dir *dir, const char *name) {
 	ASSERT (name != NULL);
 
 	/* Find directory entry. */
+	inode_lock_dir (dir->inode);
 	if (!lookup (dir, name, &e, &ofs))
 		goto done;
 
@@ -189,11 +669,36 @@ dir_remove (struct dir *dir, const char *name) {
 	if (inode_write_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
 		goto done;
 
+	/* Keep the index in step with the disk, or drop it. */
+	index = index_get (dir);
+	if (index != NULL) {
+		struct dir_name *n = index_find (index, name);
+		if (n != NULL) {
+			hash_delete (&index->names, &n->elem);
+			free (n);
+		}
+		if (!index_add_free (index, ofs))
+			index_discard (index);
+		index_put (index);
+	}
+
+	/* Forget NAME, and everything under it if it is a directory.
+	 * Locking the removed directory too, always after its parent,
+	 * keeps lookups in it from caching anything meanwhile. */
+	inode_lock_dir (inode);
+	index_drop (e.inode_sector);
+	lock_acquire (&dentry_lock);
+	dentry_invalidate (inode_get_inumber (dir->inode), name);
+	dentry_invalidate_dir (e.inode_sector);
+	lock_release (&dentry_lock);
+	inode_unlock_dir (inode);
+
 	/* Remove inode. */
 	inode_remove (inode);
 	success = true;
 
 done:
+	inode_unlock_dir (dir->inode);
 	inode_close (inode);
 	return success;
 }
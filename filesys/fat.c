@@ -1,4 +1,5 @@
 #include "filesys/fat.h"
+#include <bitmap.h>
 #include "devices/disk.h"
 #include "filesys/filesys.h"
 #include "threads/malloc.h"
@@ -22,14 +23,19 @@ struct fat_fs {
 	unsigned int *fat;
 	unsigned int fat_length;
 	disk_sector_t data_start;
-	cluster_t last_clst;
+	cluster_t last_clst;        /* Most recently allocated cluster. */
+	struct bitmap *dirty;       /* FAT sectors modified since last write. */
 	struct lock write_lock;
 };
 
+/* Number of FAT entries held by one FAT sector. */
+#define ENTRIES_PER_SECTOR (DISK_SECTOR_SIZE / sizeof (cluster_t))
+
 static struct fat_fs *fat_fs;
 
 void fat_boot_create (void);
 void fat_fs_init (void);
+static void fat_dirty_init (bool all);
 
 void
 fat_init (void) {
@@ -53,9 +59,11 @@ fat_init (void) {
 
 void
 fat_open (void) {
+	free (fat_fs->fat);
 	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT load failed");
+	fat_dirty_init (false);
 
 	// Load FAT directly from the disk
 	uint8_t *buffer = (uint8_t *) fat_fs->fat;
@@ -90,26 +98,27 @@ fat_close (void) {
 	disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
 	free (bounce);
 
-	// Write FAT directly to the disk
+	// Write back only the FAT sectors that changed since the last write
 	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_wrote = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
 	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
 	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_wrote;
+		off_t bytes_done = i * DISK_SECTOR_SIZE;
+		off_t bytes_left = fat_size_in_bytes - bytes_done;
+		if (!bitmap_test (fat_fs->dirty, i))
+			continue;
 		if (bytes_left >= DISK_SECTOR_SIZE) {
 			disk_write (filesys_disk, fat_fs->bs.fat_start + i,
-			            buffer + bytes_wrote);
-			bytes_wrote += DISK_SECTOR_SIZE;
+			            buffer + bytes_done);
 		} else {
 			bounce = calloc (1, DISK_SECTOR_SIZE);
 			if (bounce == NULL)
 				PANIC ("FAT close failed");
-			memcpy (bounce, buffer + bytes_wrote, bytes_left);
+			if (bytes_left > 0)
+				memcpy (bounce, buffer + bytes_done, bytes_left);
 			disk_write (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			bytes_wrote += bytes_left;
 			free (bounce);
 		}
+		bitmap_reset (fat_fs->dirty, i);
 	}
 }
 
@@ -120,9 +129,11 @@ fat_create (void) {
 	fat_fs_init ();
 
 	// Create FAT table
+	free (fat_fs->fat);
 	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT creation failed");
+	fat_dirty_init (true);
 
 	// Set up ROOT_DIR_CLST
 	fat_put (ROOT_DIR_CLUSTER, EOChain);
@@ -152,42 +163,116 @@ fat_boot_create (void) {
 
 void
 fat_fs_init (void) {
-	/* TODO: Your code goes here. */
+	unsigned int max_length = fat_fs->bs.fat_sectors * ENTRIES_PER_SECTOR;
+
+	/* Data clusters follow the FAT.  Entry 0 is unused, so cluster N
+	 * lives at data_start + (N - 1) * SECTORS_PER_CLUSTER. */
+	fat_fs->data_start = fat_fs->bs.fat_start + fat_fs->bs.fat_sectors;
+	fat_fs->fat_length = (fat_fs->bs.total_sectors - fat_fs->data_start)
+		/ SECTORS_PER_CLUSTER + 1;
+	if (fat_fs->fat_length > max_length)
+		fat_fs->fat_length = max_length;
+	fat_fs->last_clst = ROOT_DIR_CLUSTER;
+	lock_init (&fat_fs->write_lock);
+}
+
+/* Sets up the per-sector dirty map of the FAT.  If ALL is true,
+ * every sector starts out dirty, as for a freshly created FAT. */
+static void
+fat_dirty_init (bool all) {
+	if (fat_fs->dirty == NULL) {
+		fat_fs->dirty = bitmap_create (fat_fs->bs.fat_sectors);
+		if (fat_fs->dirty == NULL)
+			PANIC ("FAT dirty map creation failed");
+	}
+	bitmap_set_all (fat_fs->dirty, all);
 }
 
 /*----------------------------------------------------------------------------*/
 /* FAT handling                                                               */
 /*----------------------------------------------------------------------------*/
 
+/* Returns a free cluster, or 0 if the disk is full.
+ * The search starts right after the most recently allocated
+ * cluster, so that files grown together stay mostly contiguous
+ * and the scan does not revisit the full front of the table. */
+static cluster_t
+fat_find_free (void) {
+	cluster_t clst = fat_fs->last_clst;
+	unsigned int i;
+
+	for (i = 1; i < fat_fs->fat_length; i++) {
+		if (++clst >= fat_fs->fat_length)
+			clst = 1;
+		if (fat_fs->fat[clst] == 0)
+			return clst;
+	}
+	return 0;
+}
+
 /* Add a cluster to the chain.
  * If CLST is 0, start a new chain.
  * Returns 0 if fails to allocate a new cluster. */
 cluster_t
 fat_create_chain (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	cluster_t nclst;
+
+	ASSERT (clst < fat_fs->fat_length);
+
+	lock_acquire (&fat_fs->write_lock);
+	nclst = fat_find_free ();
+	if (nclst != 0) {
+		fat_put (nclst, EOChain);
+		if (clst != 0)
+			fat_put (clst, nclst);
+		fat_fs->last_clst = nclst;
+	}
+	lock_release (&fat_fs->write_lock);
+	return nclst;
 }
 
 /* Remove the chain of clusters starting from CLST.
  * If PCLST is 0, assume CLST as the start of the chain. */
 void
 fat_remove_chain (cluster_t clst, cluster_t pclst) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	while (clst != 0 && clst != EOChain) {
+		cluster_t next = fat_get (clst);
+		fat_put (clst, 0);
+		clst = next;
+	}
+	if (pclst != 0)
+		fat_put (pclst, EOChain);
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Update a value in the FAT table. */
 void
 fat_put (cluster_t clst, cluster_t val) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst != 0 && clst < fat_fs->fat_length);
+	if (fat_fs->fat[clst] != val) {
+		fat_fs->fat[clst] = val;
+		bitmap_mark (fat_fs->dirty, clst / ENTRIES_PER_SECTOR);
+	}
 }
 
 /* Fetch a value in the FAT table. */
 cluster_t
 fat_get (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst != 0 && clst < fat_fs->fat_length);
+	return fat_fs->fat[clst];
 }
 
 /* Covert a cluster # to a sector number. */
 disk_sector_t
 cluster_to_sector (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst != 0 && clst < fat_fs->fat_length);
+	return fat_fs->data_start + (clst - 1) * SECTORS_PER_CLUSTER;
+}
+
+/* Convert a sector number within the data area to its cluster #. */
+cluster_t
+sector_to_cluster (disk_sector_t sector) {
+	ASSERT (sector >= fat_fs->data_start);
+	return (sector - fat_fs->data_start) / SECTORS_PER_CLUSTER + 1;
 }
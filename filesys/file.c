@@ -1,13 +1,17 @@
 #include "filesys/file.h"
 #include <debug.h>
 #include "filesys/inode.h"
+#include "filesys/pipe.h"
 #include "threads/malloc.h"
 
 /* An open file. */
 struct file {
-	struct inode *inode;        /* File's inode. */
+	struct inode *inode;        /* File's inode, or null for a pipe. */
+	struct pipe *pipe;          /* Pipe, or null for an inode. */
+	bool pipe_writer;           /* Write end of PIPE? */
 	off_t pos;                  /* Current position. */
 	bool deny_write;            /* Has file_deny_write() been called? */
+	int refs;                   /* References, dropped by file_close(). */
 };
 
 /* Opens a file for the given INODE, of which it takes ownership,
@@ -20,6 +24,7 @@ file_open (struct inode *inode) {
 		file->inode = inode;
 		file->pos = 0;
 		file->deny_write = false;
+		file->refs = 1;
 		return file;
 	} else {
 		inode_close (inode);
@@ -28,10 +33,27 @@ file_open (struct inode *inode) {
 	}
 }
 
+/* Opens and returns a new file for the write end of PIPE if WRITER
+ * is true, or its read end otherwise.  Returns a null pointer if an
+ * allocation fails. */
+struct file *
+file_open_pipe (struct pipe *pipe, bool writer) {
+	struct file *file = calloc (1, sizeof *file);
+	if (file != NULL) {
+		file->pipe = pipe;
+		file->pipe_writer = writer;
+		file->refs = 1;
+		pipe_open (pipe, writer);
+	}
+	return file;
+}
+
 /* Opens and returns a new file for the same inode as FILE.
  * Returns a null pointer if unsuccessful. */
 struct file *
 file_reopen (struct file *file) {
+	if (file->pipe != NULL)
+		return file_open_pipe (file->pipe, file->pipe_writer);
 	return file_open (inode_reopen (file->inode));
 }
 
@@ -39,7 +61,11 @@ file_reopen (struct file *file) {
  * same inode as FILE. Returns a null pointer if unsuccessful. */
 struct file *
 file_duplicate (struct file *file) {
-	struct file *nfile = file_open (inode_reopen (file->inode));
+	struct file *nfile;
+
+	if (file->pipe != NULL)
+		return file_open_pipe (file->pipe, file->pipe_writer);
+	nfile = file_open (inode_reopen (file->inode));
 	if (nfile) {
 		nfile->pos = file->pos;
 		if (file->deny_write)
@@ -48,29 +74,54 @@ file_duplicate (struct file *file) {
 	return nfile;
 }
 
-/* Closes FILE. */
+/* Takes another reference to FILE, which shares its position
+ * with the original, and returns FILE.  Each reference is dropped
+ * by file_close(). */
+struct file *
+file_ref (struct file *file) {
+	__atomic_add_fetch (&file->refs, 1, __ATOMIC_RELAXED);
+	return file;
+}
+
+/* Drops a reference to FILE, closing it with the last one. */
 void
 file_close (struct file *file) {
-	if (file != NULL) {
-		file_allow_write (file);
-		inode_close (file->inode);
+	if (file != NULL && __atomic_sub_fetch (&file->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+		if (file->pipe != NULL)
+			pipe_close (file->pipe, file->pipe_writer);
+		else {
+			file_allow_write (file);
+			inode_close (file->inode);
+		}
 		free (file);
 	}
 }
 
-/* Returns the inode encapsulated by FILE. */
+/* Returns the inode encapsulated by FILE, or a null pointer if FILE
+ * is a pipe. */
 struct inode *
 file_get_inode (struct file *file) {
 	return file->inode;
 }
 
+/* Returns the pipe FILE is an end of, or a null pointer if FILE is
+ * not a pipe. */
+struct pipe *
+file_get_pipe (struct file *file) {
+	return file->pipe;
+}
+
 /* Reads SIZE bytes from FILE into BUFFER,
  * starting at the file's current position.
  * Returns the number of bytes actually read,
  * which may be less than SIZE if end of file is reached.
- * Advances FILE's position by the number of bytes read. */
+ * Advances FILE's position by the number of bytes read.
+ * On a pipe, waits for bytes to arrive and returns 0 only at end of
+ * file; returns -1 on a pipe's write end. */
 off_t
 file_read (struct file *file, void *buffer, off_t size) {
+	if (file->pipe != NULL)
+		return file->pipe_writer ? -1 : pipe_read (file->pipe, buffer, size);
 	off_t bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
 	file->pos += bytes_read;
 	return bytes_read;
@@ -80,21 +131,27 @@ file_read (struct file *file, void *buffer, off_t size) {
  * starting at offset FILE_OFS in the file.
  * Returns the number of bytes actually read,
  * which may be less than SIZE if end of file is reached.
- * The file's current position is unaffected. */
+ * The file's current position is unaffected.
+ * Returns -1 on a pipe, which has no offsets. */
 off_t
 file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs) {
+	if (file->pipe != NULL)
+		return -1;
 	return inode_read_at (file->inode, buffer, size, file_ofs);
 }
 
 /* Writes SIZE bytes from BUFFER into FILE,
  * starting at the file's current position.
  * Returns the number of bytes actually written,
- * which may be less than SIZE if end of file is reached.
- * (Normally we'd grow the file in that case, but file growth is
- * not yet implemented.)
- * Advances FILE's position by the number of bytes read. */
+ * which may be less than SIZE if the disk fills up.
+ * Writing past end of file grows the file.
+ * Advances FILE's position by the number of bytes read.
+ * On a pipe, waits for space as needed and returns -1 if no read
+ * end is open, or on the pipe's read end. */
 off_t
 file_write (struct file *file, const void *buffer, off_t size) {
+	if (file->pipe != NULL)
+		return file->pipe_writer ? pipe_write (file->pipe, buffer, size) : -1;
 	off_t bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
 	file->pos += bytes_written;
 	return bytes_written;
@@ -103,16 +160,32 @@ file_write (struct file *file, const void *buffer, off_t size) {
 /* Writes SIZE bytes from BUFFER into FILE,
  * starting at offset FILE_OFS in the file.
  * Returns the number of bytes actually written,
- * which may be less than SIZE if end of file is reached.
- * (Normally we'd grow the file in that case, but file growth is
- * not yet implemented.)
- * The file's current position is unaffected. */
+ * which may be less than SIZE if the disk fills up.
+ * Writing past end of file grows the file.
+ * The file's current position is unaffected.
+ * Returns -1 on a pipe, which has no offsets. */
 off_t
 file_write_at (struct file *file, const void *buffer, off_t size,
 		off_t file_ofs) {
+	if (file->pipe != NULL)
+		return -1;
 	return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Moves up to SIZE bytes from IN to OUT without copying through an
+ * intermediate buffer.  Either IN is the read end of a pipe and OUT
+ * is not a pipe, or OUT is the write end of a pipe and IN is not.  Returns the number of bytes
+ * moved, or -1 if IN and OUT are not such a pair or the pipe is
+ * broken. */
+off_t
+file_splice (struct file *in, struct file *out, off_t size) {
+	if (in->pipe != NULL && !in->pipe_writer && out->pipe == NULL)
+		return pipe_splice_to_file (in->pipe, out, size);
+	if (in->pipe == NULL && out->pipe != NULL && out->pipe_writer)
+		return pipe_splice_from_file (out->pipe, in, size);
+	return -1;
+}
+
 /* Prevents write operations on FILE's underlying inode
  * until file_allow_write() is called or FILE is closed. */
 void
@@ -136,10 +209,12 @@ file_allow_write (struct file *file) {
 	}
 }
 
-/* Returns the size of FILE in bytes. */
+/* Returns the size of FILE in bytes, or -1 if FILE is a pipe. */
 off_t
 file_length (struct file *file) {
 	ASSERT (file != NULL);
+	if (file->pipe != NULL)
+		return -1;
 	return inode_length (file->inode);
 }
 
@@ -1,24 +1,82 @@
 #include "filesys/inode.h"
-#include <list.h>
+#include <hash.h>
 #include <debug.h>
 #include <round.h>
 #include <string.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#endif
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* A sector pointer that refers to no sector: a hole in a sparse
+ * file, an index block that was never allocated, or a lookup past
+ * the end of a file.  Sector 0 always holds the free map inode or
+ * the FAT boot sector, so it never holds file data. */
+#define NO_SECTOR 0
+
+#ifdef EFILESYS
+/* Bytes in one FAT cluster. */
+#define CLUSTER_SIZE (SECTORS_PER_CLUSTER * DISK_SECTOR_SIZE)
+
 /* On-disk inode.
- * Must be exactly DISK_SECTOR_SIZE bytes long. */
+ * Must be exactly DISK_SECTOR_SIZE bytes long.
+ * File data lives in the FAT cluster chain that begins at START. */
 struct inode_disk {
-	disk_sector_t start;                /* First data sector. */
+	cluster_t start;                    /* First data cluster, 0 if none. */
 	off_t length;                       /* File size in bytes. */
 	unsigned magic;                     /* Magic number. */
 	uint32_t unused[125];               /* Not used. */
 };
 
+/* A run of consecutive clusters in a file's chain: file clusters
+ * FIRST through FIRST + CNT - 1 are disk clusters CLST through
+ * CLST + CNT - 1. */
+struct cluster_run {
+	uint32_t first;                     /* Index of first cluster in file. */
+	cluster_t clst;                     /* First disk cluster. */
+	uint32_t cnt;                       /* Number of clusters. */
+};
+#else
+/* Number of sector pointers held directly in the on-disk inode,
+ * and number of sector pointers that fit in one index block. */
+#define DIRECT_CNT 124
+#define INDIRECT_CNT (DISK_SECTOR_SIZE / sizeof (disk_sector_t))
+
+/* Largest file, in sectors, that the index can describe. */
+#define MAX_SECTORS (DIRECT_CNT + INDIRECT_CNT + INDIRECT_CNT * INDIRECT_CNT)
+
+/* On-disk inode.
+ * Must be exactly DISK_SECTOR_SIZE bytes long.
+ * Data sectors are located through DIRECT_CNT direct pointers,
+ * one indirect block of INDIRECT_CNT pointers, and one doubly
+ * indirect block of INDIRECT_CNT indirect blocks. */
+struct inode_disk {
+	off_t length;                       /* File size in bytes. */
+	unsigned magic;                     /* Magic number. */
+	disk_sector_t direct[DIRECT_CNT];   /* Direct data sectors. */
+	disk_sector_t indirect;             /* Indirect index block. */
+	disk_sector_t doubly_indirect;      /* Doubly indirect index block. */
+};
+
+/* One index block: INDIRECT_CNT sector pointers. */
+struct index_block {
+	disk_sector_t sectors[INDIRECT_CNT];
+};
+
+/* An index block kept in memory, tagged with its disk location. */
+struct cached_index {
+	disk_sector_t sector;               /* Sector of the index block. */
+	struct index_block block;           /* Its contents. */
+};
+
+#endif
+
 /* Returns the number of sectors to allocate for an inode SIZE
  * bytes long. */
 static inline size_t
@@ -28,35 +86,380 @@ bytes_to_sectors (off_t size) {
 
 /* In-memory inode. */
 struct inode {
-	struct list_elem elem;              /* Element in inode list. */
+	struct hash_elem elem;              /* Element in open_inodes. */
 	disk_sector_t sector;               /* Sector number of disk location. */
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
 	struct inode_disk data;             /* Inode content. */
+
+	/* Reads share RW; writes, which may extend the file, hold it
+	 * exclusively.  MAP_LOCK serializes readers' updates of the
+	 * lookup structures below. */
+	struct rwlock rw;                   /* Guards data and length. */
+	struct lock map_lock;               /* Guards lookups by readers. */
+	struct lock dir_lock;               /* Guards entries of a directory. */
+
+#ifdef EFILESYS
+	/* The file's cluster chain as a table of runs, built by walking
+	 * the FAT once, so that seeking to an offset costs a search of
+	 * the runs instead of a walk along the chain. */
+	struct cluster_run *runs;           /* Runs, in file order. */
+	size_t run_cnt;                     /* Number of runs in use. */
+	size_t run_cap;                     /* Number of runs allocated. */
+	size_t run_hint;                    /* Run that satisfied the last lookup. */
+	uint32_t clst_cnt;                  /* Clusters covered by RUNS. */
+	bool runs_loaded;                   /* RUNS reflects the whole chain? */
+#else
+	/* Index blocks read on behalf of this inode, so that sequential
+	 * and repeated accesses past the direct pointers do not go back
+	 * to disk for each lookup.  Allocated on first use. */
+	struct cached_index *root;          /* Doubly indirect block. */
+	struct cached_index *leaf;          /* Last indirect block used. */
+#endif
 };
 
+/* Fills SECTOR with zeros. */
+static void
+zero_sector (disk_sector_t sector) {
+	static char zeros[DISK_SECTOR_SIZE];
+
+	disk_write (filesys_disk, sector, zeros);
+}
+
+#ifdef EFILESYS
+/* Appends disk cluster CLST to the end of INODE's run table.
+ * Returns false if memory is exhausted. */
+static bool
+runs_append (struct inode *inode, cluster_t clst) {
+	struct cluster_run *last = NULL;
+
+	if (inode->run_cnt > 0)
+		last = &inode->runs[inode->run_cnt - 1];
+	if (last != NULL && last->clst + last->cnt == clst)
+		last->cnt++;
+	else {
+		if (inode->run_cnt == inode->run_cap) {
+			size_t cap = inode->run_cap > 0 ? inode->run_cap * 2 : 4;
+			struct cluster_run *runs = realloc (inode->runs, cap * sizeof *runs);
+			if (runs == NULL)
+				return false;
+			inode->runs = runs;
+			inode->run_cap = cap;
+		}
+		inode->runs[inode->run_cnt++] = (struct cluster_run) {
+			.first = inode->clst_cnt,
+			.clst = clst,
+			.cnt = 1,
+		};
+	}
+	inode->clst_cnt++;
+	return true;
+}
+
+/* Builds INODE's run table by walking its chain, if that has not
+ * been done yet.  Returns false if memory is exhausted. */
+static bool
+runs_load (struct inode *inode) {
+	cluster_t clst;
+
+	if (inode->runs_loaded)
+		return true;
+	for (clst = inode->data.start; clst != 0 && clst != EOChain;
+			clst = fat_get (clst))
+		if (!runs_append (inode, clst)) {
+			inode->run_cnt = inode->clst_cnt = inode->run_hint = 0;
+			return false;
+		}
+	inode->runs_loaded = true;
+	return true;
+}
+
+/* Returns the run of INODE that holds file cluster IDX, which must
+ * be less than INODE's cluster count. */
+static struct cluster_run *
+runs_find (struct inode *inode, uint32_t idx) {
+	struct cluster_run *r = &inode->runs[inode->run_hint];
+	size_t lo, hi;
+
+	if (r->first <= idx && idx < r->first + r->cnt)
+		return r;
+
+	lo = 0;
+	hi = inode->run_cnt;
+	while (hi - lo > 1) {
+		size_t mid = (lo + hi) / 2;
+		if (inode->runs[mid].first <= idx)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	inode->run_hint = lo;
+	return &inode->runs[lo];
+}
+
 /* Returns the disk sector that contains byte offset POS within
- * INODE.
- * Returns -1 if INODE does not contain data for a byte at offset
- * POS. */
+ * INODE.  If POS is past the end of INODE's chain and CREATE is
+ * true, the chain is first extended with zeroed clusters.
+ * Returns NO_SECTOR if INODE has no sector for offset POS. */
 static disk_sector_t
-byte_to_sector (const struct inode *inode, off_t pos) {
+byte_to_sector (struct inode *inode, off_t pos, bool create) {
+	uint32_t idx;
+	struct cluster_run *r;
+
 	ASSERT (inode != NULL);
-	if (pos < inode->data.length)
-		return inode->data.start + pos / DISK_SECTOR_SIZE;
-	else
-		return -1;
+	ASSERT (pos >= 0);
+
+	if (!runs_load (inode))
+		return NO_SECTOR;
+
+	idx = pos / CLUSTER_SIZE;
+	while (idx >= inode->clst_cnt) {
+		cluster_t tail = 0, clst;
+		unsigned i;
+
+		if (!create)
+			return NO_SECTOR;
+		if (inode->run_cnt > 0) {
+			r = &inode->runs[inode->run_cnt - 1];
+			tail = r->clst + r->cnt - 1;
+		}
+		clst = fat_create_chain (tail);
+		if (clst == 0)
+			return NO_SECTOR;
+		for (i = 0; i < SECTORS_PER_CLUSTER; i++)
+			zero_sector (cluster_to_sector (clst) + i);
+		if (!runs_append (inode, clst)) {
+			fat_remove_chain (clst, tail);
+			return NO_SECTOR;
+		}
+		if (tail == 0) {
+			inode->data.start = clst;
+			disk_write (filesys_disk, inode->sector, &inode->data);
+		}
+	}
+
+	r = runs_find (inode, idx);
+	return cluster_to_sector (r->clst + (idx - r->first))
+		+ pos / DISK_SECTOR_SIZE % SECTORS_PER_CLUSTER;
+}
+
+/* Releases all of INODE's data clusters. */
+static void
+inode_release_data (struct inode *inode) {
+	if (inode->data.start != 0)
+		fat_remove_chain (inode->data.start, 0);
+}
+
+/* Initializes INODE's in-memory run table to empty. */
+static void
+inode_init_map (struct inode *inode) {
+	inode->runs = NULL;
+	inode->run_cnt = inode->run_cap = inode->run_hint = 0;
+	inode->clst_cnt = 0;
+	inode->runs_loaded = false;
 }
 
-/* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
-static struct list open_inodes;
+/* Releases INODE's data structures kept in memory. */
+static void
+inode_free_map (struct inode *inode) {
+	free (inode->runs);
+}
+
+/* Releases SECTOR, which holds an inode. */
+static void
+release_inode_sector (disk_sector_t sector) {
+	fat_remove_chain (sector_to_cluster (sector), 0);
+}
+#else
+static void release_index (disk_sector_t, int level);
+
+/* Allocates one sector, fills it with zeros and stores its
+ * number in *SECTORP.  Returns true if successful. */
+static bool
+allocate_zeroed (disk_sector_t *sectorp) {
+	if (!free_map_allocate (1, sectorp))
+		return false;
+	zero_sector (*sectorp);
+	return true;
+}
+
+/* Loads index block SECTOR into *SLOT, allocating the slot if
+ * needed.  Returns the cached block, or a null pointer if memory
+ * is exhausted. */
+static struct index_block *
+load_index (struct cached_index **slot, disk_sector_t sector) {
+	if (*slot == NULL) {
+		*slot = malloc (sizeof **slot);
+		if (*slot == NULL)
+			return NULL;
+		(*slot)->sector = NO_SECTOR;
+	}
+	if ((*slot)->sector != sector) {
+		disk_read (filesys_disk, sector, &(*slot)->block);
+		(*slot)->sector = sector;
+	}
+	return &(*slot)->block;
+}
+
+/* Returns a pointer to the slot in index block SECTOR, loaded
+ * into cache SLOT, that holds entry IDX.  If the entry is empty
+ * and CREATE is true, allocates a zeroed sector for it and writes
+ * the index block back.  Returns NULL on failure. */
+static disk_sector_t *
+index_entry (struct cached_index **slot, disk_sector_t sector, size_t idx,
+		bool create) {
+	struct index_block *block = load_index (slot, sector);
+	if (block == NULL)
+		return NULL;
+	if (block->sectors[idx] == NO_SECTOR && create) {
+		if (!allocate_zeroed (&block->sectors[idx]))
+			return NULL;
+		disk_write (filesys_disk, sector, block);
+	}
+	return &block->sectors[idx];
+}
+
+/* Makes sure the pointer at *SECTORP, which lives in INODE's
+ * on-disk inode, refers to an allocated sector when CREATE is
+ * true.  Returns false if it does not refer to one afterward. */
+static bool
+inode_entry (struct inode *inode, disk_sector_t *sectorp, bool create) {
+	if (*sectorp == NO_SECTOR && create) {
+		if (!allocate_zeroed (sectorp))
+			return false;
+		disk_write (filesys_disk, inode->sector, &inode->data);
+	}
+	return *sectorp != NO_SECTOR;
+}
+
+/* Returns the disk sector that contains byte offset POS within
+ * INODE.  If that part of INODE is a hole and CREATE is true, a
+ * zeroed sector is allocated for it first.
+ * Returns NO_SECTOR if INODE has no sector for offset POS. */
+static disk_sector_t
+byte_to_sector (struct inode *inode, off_t pos, bool create) {
+	size_t idx;
+	disk_sector_t *entry;
+
+	ASSERT (inode != NULL);
+	ASSERT (pos >= 0);
+
+	idx = pos / DISK_SECTOR_SIZE;
+	if (idx < DIRECT_CNT) {
+		entry = &inode->data.direct[idx];
+		return inode_entry (inode, entry, create) ? *entry : NO_SECTOR;
+	}
+
+	idx -= DIRECT_CNT;
+	if (idx < INDIRECT_CNT) {
+		if (!inode_entry (inode, &inode->data.indirect, create))
+			return NO_SECTOR;
+		entry = index_entry (&inode->leaf, inode->data.indirect, idx, create);
+		return entry != NULL ? *entry : NO_SECTOR;
+	}
+
+	idx -= INDIRECT_CNT;
+	if (idx < INDIRECT_CNT * INDIRECT_CNT) {
+		if (!inode_entry (inode, &inode->data.doubly_indirect, create))
+			return NO_SECTOR;
+		entry = index_entry (&inode->root, inode->data.doubly_indirect,
+				idx / INDIRECT_CNT, create);
+		if (entry == NULL || *entry == NO_SECTOR)
+			return NO_SECTOR;
+		entry = index_entry (&inode->leaf, *entry, idx % INDIRECT_CNT, create);
+		return entry != NULL ? *entry : NO_SECTOR;
+	}
+	return NO_SECTOR;
+}
+
+/* Buffers for the index blocks that release_index() walks, one
+ * per level, so that releasing sectors cannot fail for lack of
+ * memory.  RELEASE_LOCK guards them. */
+static struct index_block release_blocks[2];
+static struct lock release_lock;
+
+/* Releases SECTOR and, if LEVEL is positive, every sector
+ * reachable from it as an index block LEVEL levels deep.  The
+ * caller must hold RELEASE_LOCK. */
+static void
+release_index (disk_sector_t sector, int level) {
+	if (sector == NO_SECTOR)
+		return;
+	if (level > 0) {
+		struct index_block *block = &release_blocks[level - 1];
+		size_t i;
+
+		disk_read (filesys_disk, sector, block);
+		for (i = 0; i < INDIRECT_CNT; i++)
+			release_index (block->sectors[i], level - 1);
+	}
+	free_map_release (sector, 1);
+}
+
+/* Releases all of INODE's data and index sectors. */
+static void
+inode_release_data (struct inode *inode) {
+	size_t i;
+
+	lock_acquire (&release_lock);
+	for (i = 0; i < DIRECT_CNT; i++)
+		release_index (inode->data.direct[i], 0);
+	release_index (inode->data.indirect, 1);
+	release_index (inode->data.doubly_indirect, 2);
+	lock_release (&release_lock);
+}
+
+/* Initializes INODE's in-memory index block cache to empty. */
+static void
+inode_init_map (struct inode *inode) {
+	inode->root = NULL;
+	inode->leaf = NULL;
+}
+
+/* Releases INODE's data structures kept in memory. */
+static void
+inode_free_map (struct inode *inode) {
+	free (inode->root);
+	free (inode->leaf);
+}
+
+/* Releases SECTOR, which holds an inode. */
+static void
+release_inode_sector (disk_sector_t sector) {
+	free_map_release (sector, 1);
+}
+#endif
+
+/* Open inodes, indexed by sector, so that opening a single inode
+ * twice returns the same `struct inode'.  OPEN_INODES_LOCK guards
+ * the table and every inode's OPEN_CNT. */
+static struct hash open_inodes;
+static struct lock open_inodes_lock;
+
+/* Returns a hash value for inode E. */
+static uint64_t
+inode_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_int (hash_entry (e, struct inode, elem)->sector);
+}
+
+/* Returns true if inode A precedes inode B. */
+static bool
+inode_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct inode, elem)->sector
+		< hash_entry (b, struct inode, elem)->sector;
+}
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
-	list_init (&open_inodes);
+	if (!hash_init (&open_inodes, inode_hash, inode_less, NULL))
+		PANIC ("open inode table creation failed");
+	lock_init (&open_inodes_lock);
+#ifndef EFILESYS
+	lock_init (&release_lock);
+#endif
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -66,32 +469,41 @@ inode_init (void) {
  * Returns false if memory or disk allocation fails. */
 bool
 inode_create (disk_sector_t sector, off_t length) {
-	struct inode_disk *disk_inode = NULL;
+	struct inode *inode = NULL;
 	bool success = false;
 
 	ASSERT (length >= 0);
 
 	/* If this assertion fails, the inode structure is not exactly
 	 * one sector in size, and you should fix that. */
-	ASSERT (sizeof *disk_inode == DISK_SECTOR_SIZE);
+	ASSERT (sizeof inode->data == DISK_SECTOR_SIZE);
+
+#ifndef EFILESYS
+	if (bytes_to_sectors (length) > MAX_SECTORS)
+		return false;
+#endif
 
-	disk_inode = calloc (1, sizeof *disk_inode);
-	if (disk_inode != NULL) {
+	/* Build the inode in memory so that the block allocation
+	 * path can be shared with inode_write_at(). */
+	inode = calloc (1, sizeof *inode);
+	if (inode != NULL) {
 		size_t sectors = bytes_to_sectors (length);
-		disk_inode->length = length;
-		disk_inode->magic = INODE_MAGIC;
-		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
-			if (sectors > 0) {
-				static char zeros[DISK_SECTOR_SIZE];
-				size_t i;
-
-				for (i = 0; i < sectors; i++) 
-					disk_write (filesys_disk, disk_inode->start + i, zeros); 
-			}
-			success = true; 
-		} 
-		free (disk_inode);
+		size_t i;
+
+		inode->sector = sector;
+		inode->data.length = length;
+		inode->data.magic = INODE_MAGIC;
+		disk_write (filesys_disk, sector, &inode->data);
+
+		success = true;
+		for (i = 0; i < sectors && success; i++)
+			success = byte_to_sector (inode, i * DISK_SECTOR_SIZE, true)
+				!= NO_SECTOR;
+		if (!success)
+			inode_release_data (inode);
+
+		inode_free_map (inode);
+		free (inode);
 	}
 	return success;
 }
@@ -101,39 +513,53 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
+	struct inode key;
+	struct hash_elem *e;
 	struct inode *inode;
 
+	lock_acquire (&open_inodes_lock);
+
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
+	key.sector = sector;
+	e = hash_find (&open_inodes, &key.elem);
+	if (e != NULL) {
+		inode = hash_entry (e, struct inode, elem);
+		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+		return inode; 
 	}
 
 	/* Allocate memory. */
 	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	if (inode == NULL) {
+		lock_release (&open_inodes_lock);
 		return NULL;
+	}
 
-	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
+	/* Initialize.  The inode is read while the lock is held so
+	 * that a concurrent opener cannot see it half loaded. */
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
+	rwlock_init (&inode->rw);
+	lock_init (&inode->map_lock);
+	lock_init (&inode->dir_lock);
+	inode_init_map (inode);
 	disk_read (filesys_disk, inode->sector, &inode->data);
+	hash_insert (&open_inodes, &inode->elem);
+	lock_release (&open_inodes_lock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+	}
 	return inode;
 }
 
@@ -153,19 +579,24 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
-
-		/* Deallocate blocks if removed. */
-		if (inode->removed) {
-			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
-		}
+	lock_acquire (&open_inodes_lock);
+	if (--inode->open_cnt > 0) {
+		lock_release (&open_inodes_lock);
+		return;
+	}
+
+	/* Remove from inode table and release lock. */
+	hash_delete (&open_inodes, &inode->elem);
+	lock_release (&open_inodes_lock);
 
-		free (inode); 
+	/* Deallocate blocks if removed. */
+	if (inode->removed) {
+		release_inode_sector (inode->sector);
+		inode_release_data (inode);
 	}
+
+	inode_free_map (inode);
+	free (inode); 
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -185,9 +616,10 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	off_t bytes_read = 0;
 	uint8_t *bounce = NULL;
 
+	rwlock_acquire_read (&inode->rw);
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
-		disk_sector_t sector_idx = byte_to_sector (inode, offset);
+		disk_sector_t sector_idx;
 		int sector_ofs = offset % DISK_SECTOR_SIZE;
 
 		/* Bytes left in inode, bytes left in sector, lesser of the two. */
@@ -200,7 +632,13 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
+		lock_acquire (&inode->map_lock);
+		sector_idx = byte_to_sector (inode, offset, false);
+		lock_release (&inode->map_lock);
+		if (sector_idx == NO_SECTOR) {
+			/* Hole in a sparse file reads back as zeros. */
+			memset (buffer + bytes_read, 0, chunk_size);
+		} else if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
 			/* Read full sector directly into caller's buffer. */
 			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
 		} else {
@@ -220,6 +658,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
+	rwlock_release_read (&inode->rw);
 	free (bounce);
 
 	return bytes_read;
@@ -227,9 +666,9 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
  * Returns the number of bytes actually written, which may be
- * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
+ * less than SIZE if the disk fills up or an error occurs.
+ * Writing past end of file extends the inode; any gap between
+ * the old end of file and OFFSET is left as a hole. */
 off_t
 inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		off_t offset) {
@@ -240,19 +679,18 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	if (inode->deny_write_cnt)
 		return 0;
 
+	rwlock_acquire_write (&inode->rw);
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
-		disk_sector_t sector_idx = byte_to_sector (inode, offset);
+		disk_sector_t sector_idx;
 		int sector_ofs = offset % DISK_SECTOR_SIZE;
 
-		/* Bytes left in inode, bytes left in sector, lesser of the two. */
-		off_t inode_left = inode_length (inode) - offset;
+		/* Bytes left in sector, lesser of that and SIZE. */
 		int sector_left = DISK_SECTOR_SIZE - sector_ofs;
-		int min_left = inode_left < sector_left ? inode_left : sector_left;
+		int chunk_size = size < sector_left ? size : sector_left;
 
-		/* Number of bytes to actually write into this sector. */
-		int chunk_size = size < min_left ? size : min_left;
-		if (chunk_size <= 0)
+		sector_idx = byte_to_sector (inode, offset, true);
+		if (sector_idx == NO_SECTOR)
 			break;
 
 		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
@@ -284,6 +722,13 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	}
 	free (bounce);
 
+	/* Extend the file if we wrote past its end. */
+	if (bytes_written > 0 && offset > inode->data.length) {
+		inode->data.length = offset;
+		disk_write (filesys_disk, inode->sector, &inode->data);
+	}
+	rwlock_release_write (&inode->rw);
+
 	return bytes_written;
 }
 
@@ -306,6 +751,20 @@ inode_allow_write (struct inode *inode) {
 	inode->deny_write_cnt--;
 }
 
+/* Locks the entries of directory INODE, and everything that the
+ * directory module keeps in memory about them, against other
+ * changes and lookups. */
+void
+inode_lock_dir (struct inode *inode) {
+	lock_acquire (&inode->dir_lock);
+}
+
+/* Unlocks the entries of directory INODE. */
+void
+inode_unlock_dir (struct inode *inode) {
+	lock_release (&inode->dir_lock);
+}
+
 /* Returns the length, in bytes, of INODE's data. */
 off_t
 inode_length (const struct inode *inode) {
@@ -0,0 +1,255 @@
+#include "filesys/pipe.h"
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Bytes buffered in a pipe, a power of two. */
+#define PIPE_SIZE PGSIZE
+
+/* A pipe: a page of bytes in flight from writers to readers.
+ * HEAD and TAIL run freely and are reduced modulo PIPE_SIZE, so
+ * HEAD - TAIL is the number of bytes buffered. */
+struct pipe {
+	struct lock lock;           /* Guards all the members below. */
+	struct condition not_empty; /* Signaled when bytes arrive. */
+	struct condition not_full;  /* Signaled when space frees up. */
+	uint8_t *buf;               /* PIPE_SIZE bytes. */
+	size_t head;                /* Where the next byte is written. */
+	size_t tail;                /* Where the next byte is read. */
+	int readers;                /* Open read ends. */
+	int writers;                /* Open write ends. */
+};
+
+/* Returns the number of bytes that can be read from P at its
+ * tail without wrapping around. */
+static size_t
+readable (const struct pipe *p) {
+	size_t n = p->head - p->tail;
+	size_t to_end = PIPE_SIZE - p->tail % PIPE_SIZE;
+	return n < to_end ? n : to_end;
+}
+
+/* Returns the number of bytes that can be written to P at its
+ * head without wrapping around. */
+static size_t
+writable (const struct pipe *p) {
+	size_t n = PIPE_SIZE - (p->head - p->tail);
+	size_t to_end = PIPE_SIZE - p->head % PIPE_SIZE;
+	return n < to_end ? n : to_end;
+}
+
+/* Creates a pipe and opens its read end as *RD and its write end
+ * as *WR.  Returns false if memory is exhausted. */
+bool
+pipe_create (struct file **rd, struct file **wr) {
+	struct pipe *p = calloc (1, sizeof *p);
+	if (p == NULL)
+		return false;
+	p->buf = palloc_get_page (0);
+	if (p->buf == NULL) {
+		free (p);
+		return false;
+	}
+	lock_init (&p->lock);
+	cond_init (&p->not_empty);
+	cond_init (&p->not_full);
+
+	*rd = file_open_pipe (p, false);
+	*wr = file_open_pipe (p, true);
+	if (*rd != NULL && *wr != NULL)
+		return true;
+
+	/* Closing the only open end frees the pipe. */
+	if (*rd != NULL)
+		file_close (*rd);
+	else if (*wr != NULL)
+		file_close (*wr);
+	else {
+		palloc_free_page (p->buf);
+		free (p);
+	}
+	return false;
+}
+
+/* Opens another read end of P, or write end if WRITER is true. */
+void
+pipe_open (struct pipe *p, bool writer) {
+	lock_acquire (&p->lock);
+	if (writer)
+		p->writers++;
+	else
+		p->readers++;
+	lock_release (&p->lock);
+}
+
+/* Closes a read end of P, or write end if WRITER is true, and frees
+ * P if that was the last end open.  Closing the last write end lets
+ * readers see end of file, and closing the last read end breaks the
+ * pipe for writers. */
+void
+pipe_close (struct pipe *p, bool writer) {
+	bool last;
+
+	lock_acquire (&p->lock);
+	if (writer) {
+		ASSERT (p->writers > 0);
+		if (--p->writers == 0)
+			cond_broadcast (&p->not_empty, &p->lock);
+	} else {
+		ASSERT (p->readers > 0);
+		if (--p->readers == 0)
+			cond_broadcast (&p->not_full, &p->lock);
+	}
+	last = p->readers == 0 && p->writers == 0;
+	lock_release (&p->lock);
+
+	if (last) {
+		palloc_free_page (p->buf);
+		free (p);
+	}
+}
+
+/* Wakes every thread waiting on P, so that a killed one can give
+ * up. */
+void
+pipe_wake (struct pipe *p) {
+	lock_acquire (&p->lock);
+	cond_broadcast (&p->not_empty, &p->lock);
+	cond_broadcast (&p->not_full, &p->lock);
+	lock_release (&p->lock);
+}
+
+/* Returns true if the running thread should stop waiting on a pipe
+ * because it has been killed. */
+static bool
+killed (void) {
+	return thread_current ()->killed;
+}
+
+/* Reads up to SIZE bytes from P into BUFFER, waiting until at least
+ * one byte is buffered.  Returns the number of bytes read, which is
+ * 0 only at end of file, when no write end is open, or if the
+ * running thread is killed while waiting. */
+off_t
+pipe_read (struct pipe *p, void *buffer, off_t size) {
+	uint8_t *dst = buffer;
+	off_t done = 0;
+
+	lock_acquire (&p->lock);
+	while (p->head == p->tail && p->writers > 0 && size > 0 && !killed ())
+		cond_wait (&p->not_empty, &p->lock);
+	while (done < size && p->head != p->tail) {
+		size_t n = readable (p);
+		if (n > (size_t) (size - done))
+			n = size - done;
+		memcpy (dst + done, p->buf + p->tail % PIPE_SIZE, n);
+		p->tail += n;
+		done += n;
+	}
+	if (done > 0)
+		cond_broadcast (&p->not_full, &p->lock);
+	lock_release (&p->lock);
+	return done;
+}
+
+/* Writes SIZE bytes from BUFFER to P, waiting for space as needed.
+ * Returns the number of bytes written, which is less than SIZE only
+ * if the pipe breaks, or -1 if it was broken before any byte was
+ * written. */
+off_t
+pipe_write (struct pipe *p, const void *buffer, off_t size) {
+	const uint8_t *src = buffer;
+	off_t done = 0;
+
+	lock_acquire (&p->lock);
+	while (done < size && p->readers > 0) {
+		size_t n = writable (p);
+		if (n == 0) {
+			if (killed ())
+				break;
+			cond_wait (&p->not_full, &p->lock);
+			continue;
+		}
+		if (n > (size_t) (size - done))
+			n = size - done;
+		memcpy (p->buf + p->head % PIPE_SIZE, src + done, n);
+		p->head += n;
+		done += n;
+		cond_broadcast (&p->not_empty, &p->lock);
+	}
+	lock_release (&p->lock);
+	return done == 0 && size > 0 ? -1 : done;
+}
+
+/* Moves up to SIZE bytes from P to FILE at its current position,
+ * writing straight out of the pipe's buffer.  Waits like
+ * pipe_read().  Returns the number of bytes moved, which is 0 only
+ * at end of file or if FILE cannot be written. */
+off_t
+pipe_splice_to_file (struct pipe *p, struct file *file, off_t size) {
+	off_t done = 0;
+
+	lock_acquire (&p->lock);
+	while (p->head == p->tail && p->writers > 0 && size > 0 && !killed ())
+		cond_wait (&p->not_empty, &p->lock);
+	while (done < size && p->head != p->tail) {
+		size_t n = readable (p);
+		off_t put;
+
+		if (n > (size_t) (size - done))
+			n = size - done;
+		put = file_write (file, p->buf + p->tail % PIPE_SIZE, n);
+		if (put <= 0)
+			break;
+		p->tail += put;
+		done += put;
+		if ((size_t) put < n)
+			break;
+	}
+	if (done > 0)
+		cond_broadcast (&p->not_full, &p->lock);
+	lock_release (&p->lock);
+	return done;
+}
+
+/* Moves up to SIZE bytes from FILE at its current position to P,
+ * reading straight into the pipe's buffer and waiting for space as
+ * needed.  Returns the number of bytes moved, which is less than
+ * SIZE at end of file or if the pipe breaks, or -1 if it was broken
+ * before any byte was moved. */
+off_t
+pipe_splice_from_file (struct pipe *p, struct file *file, off_t size) {
+	off_t done = 0;
+	bool broken;
+
+	lock_acquire (&p->lock);
+	while (done < size && p->readers > 0) {
+		size_t n = writable (p);
+		off_t got;
+
+		if (n == 0) {
+			if (killed ())
+				break;
+			cond_wait (&p->not_full, &p->lock);
+			continue;
+		}
+		if (n > (size_t) (size - done))
+			n = size - done;
+		got = file_read (file, p->buf + p->head % PIPE_SIZE, n);
+		if (got > 0) {
+			p->head += got;
+			done += got;
+			cond_broadcast (&p->not_empty, &p->lock);
+		}
+		if (got < 0 || (size_t) got < n)
+			break;
+	}
+	broken = p->readers == 0;
+	lock_release (&p->lock);
+	return done == 0 && size > 0 && broken ? -1 : done;
+}
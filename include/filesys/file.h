@@ -1,22 +1,28 @@
 #ifndef FILESYS_FILE_H
 #define FILESYS_FILE_H
 
+#include <stdbool.h>
 #include "filesys/off_t.h"
 
 struct inode;
+struct pipe;
 
 /* Opening and closing files. */
 struct file *file_open (struct inode *);
+struct file *file_open_pipe (struct pipe *, bool writer);
 struct file *file_reopen (struct file *);
 struct file *file_duplicate (struct file *file);
+struct file *file_ref (struct file *);
 void file_close (struct file *);
 struct inode *file_get_inode (struct file *);
+struct pipe *file_get_pipe (struct file *);
 
 /* Reading and writing. */
 off_t file_read (struct file *, void *, off_t);
 off_t file_read_at (struct file *, void *, off_t size, off_t start);
 off_t file_write (struct file *, const void *, off_t);
 off_t file_write_at (struct file *, const void *, off_t size, off_t start);
+off_t file_splice (struct file *in, struct file *out, off_t size);
 
 /* Preventing writes. */
 void file_deny_write (struct file *);
@@ -3,10 +3,18 @@
 
 #include <stdbool.h>
 #include "filesys/off_t.h"
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#endif
 
 /* Sectors of system file inodes. */
 #define FREE_MAP_SECTOR 0       /* Free map file inode sector. */
+#ifdef EFILESYS
+/* Root directory file inode sector. */
+#define ROOT_DIR_SECTOR (cluster_to_sector (ROOT_DIR_CLUSTER))
+#else
 #define ROOT_DIR_SECTOR 1       /* Root directory file inode sector. */
+#endif
 
 /* Disk used for file system. */
 extern struct disk *filesys_disk;
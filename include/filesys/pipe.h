@@ -0,0 +1,23 @@
+#ifndef FILESYS_PIPE_H
+#define FILESYS_PIPE_H
+
+#include <stdbool.h>
+#include "filesys/off_t.h"
+
+struct file;
+struct pipe;
+
+bool pipe_create (struct file **rd, struct file **wr);
+void pipe_open (struct pipe *, bool writer);
+void pipe_close (struct pipe *, bool writer);
+void pipe_wake (struct pipe *);
+
+/* Moving bytes through a pipe. */
+off_t pipe_read (struct pipe *, void *, off_t);
+off_t pipe_write (struct pipe *, const void *, off_t);
+
+/* Moving bytes between a pipe and a file. */
+off_t pipe_splice_to_file (struct pipe *, struct file *, off_t);
+off_t pipe_splice_from_file (struct pipe *, struct file *, off_t);
+
+#endif /* filesys/pipe.h */
@@ -28,6 +28,7 @@
 /* Hash element. */
 struct hash_elem {
 	struct list_elem list_elem;
+	uint64_t hash;              /* Hash value, kept by the table. */
 };
 
 /* Converts pointer to hash element HASH_ELEM into a pointer to
@@ -96,5 +97,6 @@ bool hash_empty (struct hash *);
 uint64_t hash_bytes (const void *, size_t);
 uint64_t hash_string (const char *);
 uint64_t hash_int (int);
+uint64_t hash_ptr (const void *);
 
 #endif /* lib/kernel/hash.h */
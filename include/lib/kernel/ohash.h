@@ -0,0 +1,76 @@
+#ifndef __LIB_KERNEL_OHASH_H
+#define __LIB_KERNEL_OHASH_H
+
+/* Open-addressing hash table.
+ *
+ * A drop-in alternative to the chained table in hash.h, for tables
+ * that are searched much more often than they change.  It stores
+ * the same struct hash_elem and takes the same hash and comparison
+ * functions, and its functions mirror hash.h's with an "ohash_"
+ * prefix, so switching a table from one to the other changes only
+ * the names.
+ *
+ * Elements live in one array of slots, each holding an element
+ * pointer and its hash value, and a search walks forward from the
+ * slot the hash value picks until it meets an empty slot
+ * ("linear probing").  A lookup therefore reads consecutive memory
+ * and calls the comparison function only on a hash value match,
+ * where a chained table follows a pointer for every element in
+ * the bucket.  Deletion moves later elements of the same run back
+ * rather than leaving markers behind, so searches never slow down
+ * as the table is used.
+ *
+ * The table grows when three quarters of its slots are in use and
+ * shrinks when fewer than one in eight are.  Since it must keep an
+ * empty slot, ohash_insert() and ohash_replace() fail, returning
+ * the new element, if it is full and cannot grow. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "hash.h"
+
+/* One slot of an open-addressing table. */
+struct ohash_slot {
+	uint64_t hash;              /* Hash value of ELEM. */
+	struct hash_elem *elem;     /* Element, or null if the slot is empty. */
+};
+
+/* Open-addressing hash table. */
+struct ohash {
+	size_t elem_cnt;            /* Number of elements in table. */
+	size_t slot_cnt;            /* Number of slots, a power of 2. */
+	struct ohash_slot *slots;   /* Array of `slot_cnt' slots. */
+	hash_hash_func *hash;       /* Hash function. */
+	hash_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `hash' and `less'. */
+};
+
+/* An open-addressing hash table iterator. */
+struct ohash_iterator {
+	struct ohash *hash;         /* The hash table. */
+	struct ohash_slot *slot;    /* Current slot. */
+};
+
+/* Basic life cycle. */
+bool ohash_init (struct ohash *, hash_hash_func *, hash_less_func *, void *aux);
+void ohash_clear (struct ohash *, hash_action_func *);
+void ohash_destroy (struct ohash *, hash_action_func *);
+
+/* Search, insertion, deletion. */
+struct hash_elem *ohash_insert (struct ohash *, struct hash_elem *);
+struct hash_elem *ohash_replace (struct ohash *, struct hash_elem *);
+struct hash_elem *ohash_find (struct ohash *, struct hash_elem *);
+struct hash_elem *ohash_delete (struct ohash *, struct hash_elem *);
+
+/* Iteration. */
+void ohash_apply (struct ohash *, hash_action_func *);
+void ohash_first (struct ohash_iterator *, struct ohash *);
+struct hash_elem *ohash_next (struct ohash_iterator *);
+struct hash_elem *ohash_cur (struct ohash_iterator *);
+
+/* Information. */
+size_t ohash_size (struct ohash *);
+bool ohash_empty (struct ohash *);
+
+#endif /* lib/kernel/ohash.h */
@@ -0,0 +1,55 @@
+#ifndef __LIB_RING_H
+#define __LIB_RING_H
+
+#include <stdint.h>
+
+/* Submission/completion ring shared between a user process and the
+ * kernel.  The process queues requests in SQ and advances SQ_TAIL;
+ * ring_enter() runs queued requests, advancing SQ_HEAD, and posts
+ * one completion per request to CQ, advancing CQ_TAIL.  The process
+ * consumes completions and advances CQ_HEAD.  Indexes run freely
+ * and are reduced modulo ENTRIES, which is a power of two. */
+
+/* Request opcodes. */
+enum ring_op {
+	RING_OP_NOP,                /* Does nothing. */
+	RING_OP_READ,               /* read() or pread(). */
+	RING_OP_WRITE,              /* write() or pwrite(). */
+	RING_OP_OPEN,               /* open(). */
+	RING_OP_CLOSE,              /* close(). */
+	RING_OP_FSYNC,              /* Flush a file to disk. */
+};
+
+/* Submission queue entry. */
+struct ring_sqe {
+	uint32_t opcode;            /* One of RING_OP_*. */
+	int32_t fd;                 /* File descriptor. */
+	uint64_t addr;              /* Buffer or file name. */
+	uint32_t len;               /* Buffer length. */
+	int32_t off;                /* File offset, or -1 for current position. */
+	uint64_t user_data;         /* Copied to the completion. */
+};
+
+/* Completion queue entry. */
+struct ring_cqe {
+	uint64_t user_data;         /* From the submission. */
+	int32_t res;                /* What the system call would return. */
+	uint32_t flags;             /* Unused. */
+};
+
+/* Maximum number of entries in each queue. */
+#define RING_MAX_ENTRIES 64
+
+/* The shared ring, one page mapped into the process. */
+struct ring {
+	uint32_t sq_head;           /* Next request to run; kernel writes. */
+	uint32_t sq_tail;           /* Next free request slot; user writes. */
+	uint32_t cq_head;           /* Next completion to reap; user writes. */
+	uint32_t cq_tail;           /* Next free completion slot; kernel writes. */
+	uint32_t entries;           /* Entries in each queue. */
+	uint32_t reserved[11];
+	struct ring_sqe sq[RING_MAX_ENTRIES];
+	struct ring_cqe cq[RING_MAX_ENTRIES];
+};
+
+#endif /* lib/ring.h */
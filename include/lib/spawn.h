@@ -0,0 +1,28 @@
+#ifndef __LIB_SPAWN_H
+#define __LIB_SPAWN_H
+
+#include <stdint.h>
+
+/* Descriptor changes that spawn() makes in the child before it
+ * loads the program.  The child starts with a copy of the caller's
+ * descriptors and the actions are applied in order. */
+
+/* Action opcodes. */
+enum spawn_op {
+	SPAWN_OPEN,                 /* Open PATH as FD. */
+	SPAWN_DUP2,                 /* Make FD refer to the file open as SRC. */
+	SPAWN_CLOSE,                /* Close FD. */
+};
+
+/* One descriptor action. */
+struct spawn_action {
+	uint32_t op;                /* One of SPAWN_*. */
+	int32_t fd;                 /* Descriptor to change. */
+	int32_t src;                /* Source descriptor for SPAWN_DUP2. */
+	const char *path;           /* File name for SPAWN_OPEN. */
+};
+
+/* Maximum number of actions in one spawn() call. */
+#define SPAWN_ACTIONS_MAX 16
+
+#endif /* lib/spawn.h */
@@ -36,6 +36,25 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Positional and vectored I/O. */
+	SYS_PREAD,                  /* Read from a file at an offset. */
+	SYS_PWRITE,                 /* Write to a file at an offset. */
+	SYS_READV,                  /* Read from a file into several buffers. */
+	SYS_WRITEV,                 /* Write to a file from several buffers. */
+	SYS_COPY_FILE_RANGE,        /* Copy between files within the kernel. */
+	SYS_RING_SETUP,             /* Map a submission/completion ring. */
+	SYS_RING_ENTER,             /* Run requests queued in the ring. */
+	SYS_PIPE,                   /* Create a pipe. */
+	SYS_SPLICE,                 /* Move bytes between a pipe and a file. */
+	SYS_FUTEX_WAIT,             /* Wait on a user memory word. */
+	SYS_FUTEX_WAKE,             /* Wake waiters on a user memory word. */
+	SYS_THREAD_CREATE,          /* Start a thread in this process. */
+	SYS_THREAD_JOIN,            /* Wait for a thread to exit. */
+	SYS_THREAD_EXIT,            /* End the calling thread. */
+	SYS_SBRK,                   /* Move the end of the heap. */
+	SYS_SPAWN,                  /* Start a program in a new process. */
+	SYS_VFORK,                  /* Clone, borrowing the address space. */
 };
 
 #endif /* lib/syscall-nr.h */
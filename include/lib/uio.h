@@ -0,0 +1,15 @@
+#ifndef __LIB_UIO_H
+#define __LIB_UIO_H
+
+#include <stddef.h>
+
+/* One buffer of a scatter/gather I/O request. */
+struct iovec {
+	void *iov_base;             /* Start of buffer. */
+	size_t iov_len;             /* Number of bytes in buffer. */
+};
+
+/* Maximum number of buffers in one readv() or writev() call. */
+#define IOV_MAX 1024
+
+#endif /* lib/uio.h */
@@ -0,0 +1,32 @@
+#ifndef __LIB_USER_FUTEX_H
+#define __LIB_USER_FUTEX_H
+
+#include <stdbool.h>
+
+/* A mutual exclusion lock.  Locking and unlocking an uncontended
+   mutex make no system call; a thread that finds it held sleeps in
+   futex_wait(). */
+struct mutex {
+	int state;          /* 0: unlocked; 1: locked; 2: locked, waiters. */
+};
+
+#define MUTEX_INITIALIZER { 0 }
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+
+/* A condition variable, used together with a mutex. */
+struct condvar {
+	int seq;            /* Bumped by every signal and broadcast. */
+};
+
+#define CONDVAR_INITIALIZER { 0 }
+
+void condvar_init (struct condvar *);
+void condvar_wait (struct condvar *, struct mutex *);
+void condvar_signal (struct condvar *);
+void condvar_broadcast (struct condvar *);
+
+#endif /* lib/user/futex.h */
@@ -4,11 +4,20 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <ring.h>
+#include <spawn.h>
+#include <syscall-nr.h>
+#include <uio.h>
 
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
+/* Thread identifier. */
+typedef int tid_t;
+#define TID_ERROR ((tid_t) -1)
+
 /* Map region identifier. */
 typedef int off_t;
 #define MAP_FAILED ((void *) NULL)
@@ -38,6 +47,42 @@ void close (int fd);
 
 int dup2(int oldfd, int newfd);
 
+/* Positional and vectored I/O. */
+int pread (int fd, void *buffer, unsigned length, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int copy_file_range (int in_fd, int out_fd, unsigned length);
+
+/* Pipes. */
+int pipe (int fds[2]);
+int splice (int fd_in, int fd_out, unsigned length);
+
+/* Waiting on memory words (see <futex.h> for locks built on them). */
+int futex_wait (int *addr, int val);
+int futex_wake (int *addr, int cnt);
+
+/* Threads sharing this process's memory and descriptors. */
+tid_t thread_create (void (*function) (void *), void *aux);
+int thread_join (tid_t);
+void thread_exit (int status) NO_RETURN;
+
+/* Heap (see <malloc.h> for an allocator built on it). */
+void *sbrk (intptr_t increment);
+
+/* Starting programs without copying this process. */
+pid_t spawn (const char *cmd_line, const struct spawn_action *actions,
+             int action_cnt);
+static inline pid_t vfork (void) __attribute__ ((always_inline, returns_twice));
+
+/* Batched system calls through a shared ring (see <ring.h>). */
+struct ring *ring_setup (unsigned entries);
+int ring_enter (unsigned to_submit);
+struct ring_sqe *ring_get_sqe (struct ring *);
+int ring_submit (struct ring *);
+struct ring_cqe *ring_peek_cqe (struct ring *);
+void ring_cqe_seen (struct ring *);
+
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
@@ -78,4 +123,32 @@ get_fs_disk_write_cnt (void) {
 	return write_cnt;
 }
 
+static inline long long
+get_timer_ticks (void) {
+	long long ticks;
+	asm volatile ("int $0x45" : "=a" (ticks) : : "memory");
+	return ticks;
+}
+
+/* Like fork(), but the child runs in this process's memory, on
+   its stack, and the caller is suspended until the child calls
+   exec() or exits.  Always inlined, so that the child cannot
+   overwrite a return address that the caller still needs. */
+static inline pid_t
+vfork (void) {
+	pid_t pid;
+	asm volatile ("syscall"
+	              : "=a" (pid)
+	              : "a" ((uint64_t) SYS_VFORK)
+	              : "rcx", "r11", "memory");
+	return pid;
+}
+
+static inline long long
+get_user_frame_cnt (void) {
+	long long cnt;
+	asm volatile ("int $0x46" : "=a" (cnt) : : "memory");
+	return cnt;
+}
+
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,32 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#include <stdint.h>
+
+/* Voluntary context switch, in switch.S.
+ *
+ * Saves the callee-saved registers on the current kernel stack,
+ * stores the stack pointer in *CUR_RSP, loads NEXT_RSP, and pops
+ * the next thread's callee-saved registers.  Everything else is
+ * already saved by the C calling convention, because schedule()
+ * is an ordinary function call, even when it runs because of a
+ * timer interrupt (see intr_yield_on_return()). */
+void switch_threads (uint64_t *cur_rsp, uint64_t next_rsp);
+
+/* Return address of the frame that thread_create() builds for a
+ * thread that has never run.  It launches the thread from its
+ * `struct intr_frame', whose address is in rbx, using do_iret(). */
+void switch_entry (void);
+
+/* Frame popped by switch_threads(), lowest address first. */
+struct switch_frame {
+	uint64_t r15;
+	uint64_t r14;
+	uint64_t r13;
+	uint64_t r12;
+	uint64_t rbp;
+	uint64_t rbx;
+	void (*rip) (void);
+};
+
+#endif /* threads/switch.h */
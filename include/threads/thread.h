@@ -108,10 +108,8 @@ struct thread {
 
 	/* Project 2 */
 	int exit_status;
-	//struct file * fdt[128];
-	struct file ** fdt;
-	
-	int fd;
+	bool killed;                        /* Exit before running user code again. */
+	struct fd_table *fdt;               /* Open file descriptors. */
 
 	struct intr_frame userland_if; 
 
@@ -128,14 +126,24 @@ struct thread {
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t *pml4;                     /* Page map level 4 */
+	struct thread_group *group;         /* Shared with sibling threads, or null. */
+	struct list_elem group_elem;        /* Element in GROUP's member list. */
+	int stack_slot;                     /* User thread's stack, or -1 if initial. */
+	uintptr_t heap_start;               /* Start of heap, unless in GROUP. */
+	uintptr_t heap_brk;                 /* End of heap, unless in GROUP. */
+	struct thread *vfork_parent;        /* Lender of PML4 until exec or exit. */
 #endif
 #ifdef VM
 	/* Table for whole virtual memory owned by thread. */
 	struct supplemental_page_table spt;
 #endif
 
+	/* Owned by threads/fpu.c. */
+	void *fpu;                          /* x87/SSE save area, or null. */
+
 	/* Owned by thread.c. */
-	struct intr_frame tf;               /* Information for switching */
+	struct intr_frame tf;               /* Information for the first launch. */
+	uint64_t switch_rsp;                /* Saved stack pointer, see switch.S. */
 	unsigned magic;                     /* Detects stack overflow. */
 };
 
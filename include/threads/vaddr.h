@@ -20,6 +20,12 @@
 #define PGSIZE  (1 << PGBITS)              /* Bytes in a page. */
 #define PGMASK  BITMASK(PGSHIFT, PGBITS)   /* Page offset bits (0:12). */
 
+/* Huge pages, mapped by a single page directory entry. */
+#define HPGBITS 21                         /* Number of offset bits. */
+#define HPGSIZE (1 << HPGBITS)             /* Bytes in a huge page. */
+#define HPGCNT  (HPGSIZE / PGSIZE)         /* Pages in a huge page. */
+#define hpg_round_down(va) ((void *) ((uint64_t) (va) & ~(uint64_t) (HPGSIZE - 1)))
+
 /* Offset within a page. */
 #define pg_ofs(va) ((uint64_t) (va) & PGMASK)
 
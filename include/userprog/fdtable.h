@@ -0,0 +1,49 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/synch.h"
+
+struct file;
+
+/* Descriptors 0 and 1 are the console.  They are always reserved
+ * and never map to a file. */
+#define STDIN_FILENO 0
+#define STDOUT_FILENO 1
+
+/* Largest number of descriptors a process may have, counting the
+ * console.  One summary word covers every bitmap word. */
+#define FD_MAX (64 * 64)
+
+/* Number of descriptors held inside struct fd_table itself, so
+ * that most processes need a single allocation. */
+#define FD_INLINE_CNT 16
+
+/* A process's file descriptor table, shared by its threads.
+ * Grows by doubling.  USED has a bit per descriptor and FULL has a
+ * bit per word of USED that has no clear bits, so finding the
+ * lowest free descriptor reads two words. */
+struct fd_table {
+	struct lock lock;                   /* Guards all the members below. */
+	struct file **files;                /* Open files, indexed by fd. */
+	uint64_t *used;                     /* Bit set if fd is in use. */
+	uint64_t full;                      /* Bit set if USED word is full. */
+	int cap;                            /* Number of descriptors. */
+
+	struct file *inline_files[FD_INLINE_CNT]; /* Initial FILES. */
+	uint64_t inline_used;               /* Initial USED. */
+};
+
+struct fd_table *fd_table_create (void);
+bool fd_table_copy (struct fd_table *dst, struct fd_table *src);
+void fd_table_destroy (struct fd_table *);
+void fd_table_wake_pipes (struct fd_table *);
+
+int fd_install (struct fd_table *, struct file *);
+bool fd_install_at (struct fd_table *, int fd, struct file *);
+struct file *fd_get (struct fd_table *, int fd);
+void fd_put (struct file *);
+struct file *fd_remove (struct fd_table *, int fd);
+
+#endif /* userprog/fdtable.h */
@@ -0,0 +1,11 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+#include <stdint.h>
+
+void futex_init (void);
+int futex_wait (const int32_t *key, int32_t val);
+int futex_wake (const int32_t *key, int cnt);
+void futex_wake_killed (void);
+
+#endif /* userprog/futex.h */
@@ -0,0 +1,32 @@
+#ifndef USERPROG_PERCPU_H
+#define USERPROG_PERCPU_H
+
+/* Per-CPU area.
+ *
+ * syscall_entry needs somewhere to put the user stack pointer and
+ * to find the kernel stack before it has a stack of its own.  The
+ * per-CPU area holds both.  Its address sits in the
+ * IA32_KERNEL_GS_BASE MSR, and the entry code brings it into GS
+ * with SWAPGS, so each CPU reaches its own area through %gs
+ * without any shared global.  There is one CPU, so one area. */
+
+/* Offsets of the members of struct percpu, for assembly code. */
+#define PERCPU_KERNEL_RSP 0
+#define PERCPU_USER_RSP 8
+#define PERCPU_CURR 16
+
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+
+struct thread;
+
+struct percpu {
+	uint64_t kernel_rsp;        /* Top of the running thread's kernel stack. */
+	uint64_t user_rsp;          /* Scratch: user rsp during syscall entry. */
+	struct thread *curr;        /* Running thread. */
+};
+
+extern struct percpu percpu;
+#endif
+
+#endif /* userprog/percpu.h */
@@ -3,10 +3,19 @@
 
 #include "threads/thread.h"
 
+struct fd_table;
+
 tid_t process_create_initd (const char *file_name);
 tid_t process_fork (const char *name, struct intr_frame *if_);
 int process_exec (void *f_name);
+tid_t process_spawn (char *cmd_line, struct fd_table *fdt);
+tid_t process_vfork (struct intr_frame *if_);
 int process_wait (tid_t);
+tid_t process_create_thread (void *entry, uint64_t arg0, uint64_t arg1);
+int process_join (tid_t);
+void process_exit_group (int status);
+void *process_sbrk (intptr_t increment);
+bool process_heap_fault (void *fault_addr);
 void process_exit (void);
 void process_activate (struct thread *next);
 
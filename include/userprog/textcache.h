@@ -0,0 +1,15 @@
+#ifndef USERPROG_TEXTCACHE_H
+#define USERPROG_TEXTCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+
+struct file;
+
+void text_cache_init (void);
+void *text_cache_get (struct file *, off_t ofs, size_t read_bytes);
+void text_cache_dup (void *kpage);
+void text_cache_put (void *kpage);
+
+#endif /* userprog/textcache.h */
@@ -0,0 +1,17 @@
+#ifndef USERPROG_UACCESS_H
+#define USERPROG_UACCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct intr_frame;
+
+bool is_user_range (const void *uaddr, size_t size);
+bool copy_from_user (void *dst, const void *usrc, size_t size);
+bool copy_to_user (void *udst, const void *src, size_t size);
+int64_t strncpy_from_user (char *dst, const char *usrc, size_t size);
+
+bool uaccess_fixup (struct intr_frame *);
+
+#endif /* userprog/uaccess.h */
@@ -3,6 +3,7 @@
 #include <limits.h>
 #include <round.h>
 #include <stdio.h>
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
 #ifdef FILESYS
 #include "filesys/file.h"
@@ -27,6 +28,8 @@ typedef unsigned long elem_type;
 struct bitmap {
 	size_t bit_cnt;     /* Number of bits. */
 	elem_type *bits;    /* Elements that represent bits. */
+	size_t clear_hint;  /* No bit below this index is false. */
+	unsigned clear_seq; /* Incremented whenever bits become false. */
 };
 
 /* Returns the index of the element that contains the bit
@@ -43,6 +46,46 @@ bit_mask (size_t bit_idx) {
 	return (elem_type) 1 << (bit_idx % ELEM_BITS);
 }
 
+/* Returns an elem_type with the bits for bit indexes START
+   through END - 1 turned on, all of which must lie within one
+   element.  END may be the first bit of the next element. */
+static inline elem_type
+range_mask (size_t start, size_t end) {
+	elem_type high = end % ELEM_BITS ? bit_mask (end) - 1 : (elem_type) -1;
+	return high & ~(bit_mask (start) - 1);
+}
+
+/* Records that bit BIT_IDX in B has just become false: lowers the
+   hint to it and tells scans in progress not to raise the hint
+   past it.  Callers such as palloc_free_multiple() hold no lock
+   and may run with interrupts off, so disabling interrupts is
+   what keeps this atomic with bitmap_scan_and_flip(). */
+static void
+note_clear (struct bitmap *b, size_t bit_idx) {
+	enum intr_level old_level = intr_disable ();
+	if (bit_idx < b->clear_hint)
+		b->clear_hint = bit_idx;
+	b->clear_seq++;
+	intr_set_level (old_level);
+}
+
+/* Returns the element numbered IDX in B, inverted if VALUE is
+   false, so that the bits set to VALUE read as 1. */
+static inline elem_type
+elem_for (const struct bitmap *b, size_t idx, bool value) {
+	return value ? b->bits[idx] : ~b->bits[idx];
+}
+
+/* Returns the number of bits set in E.  The kernel has no libgcc
+   to provide __builtin_popcountl(). */
+static inline size_t
+popcount (elem_type e) {
+	e = e - ((e >> 1) & 0x5555555555555555UL);
+	e = (e & 0x3333333333333333UL) + ((e >> 2) & 0x3333333333333333UL);
+	e = (e + (e >> 4)) & 0x0f0f0f0f0f0f0f0fUL;
+	return (e * 0x0101010101010101UL) >> 56;
+}
+
 /* Returns the number of elements required for BIT_CNT bits. */
 static inline size_t
 elem_cnt (size_t bit_cnt) {
@@ -75,6 +118,8 @@ bitmap_create (size_t bit_cnt) {
 	if (b != NULL) {
 		b->bit_cnt = bit_cnt;
 		b->bits = malloc (byte_cnt (bit_cnt));
+		b->clear_hint = 0;
+		b->clear_seq = 0;
 		if (b->bits != NULL || bit_cnt == 0) {
 			bitmap_set_all (b, false);
 			return b;
@@ -95,6 +140,8 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
 
 	b->bit_cnt = bit_cnt;
 	b->bits = (elem_type *) (b + 1);
+	b->clear_hint = 0;
+	b->clear_seq = 0;
 	bitmap_set_all (b, false);
 	return b;
 }
@@ -160,6 +207,7 @@ bitmap_reset (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the AND instruction in [IA32-v2a]. */
 	asm ("lock andq %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+	note_clear (b, bit_idx);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -174,6 +222,7 @@ bitmap_flip (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the XOR instruction in [IA32-v2b]. */
 	asm ("lock xorq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+	note_clear (b, bit_idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -186,6 +235,27 @@ bitmap_test (const struct bitmap *b, size_t idx) {
 
 /* Setting and testing multiple bits. */
 
+/* Returns the index of the first bit in B at or after START and
+   before LIMIT that is set to VALUE, or LIMIT if there is none.
+   Elements with no such bit are passed over whole. */
+static size_t
+next_bit (const struct bitmap *b, size_t start, size_t limit, bool value) {
+	size_t idx;
+	elem_type elem;
+
+	if (start >= limit)
+		return limit;
+	idx = elem_idx (start);
+	elem = elem_for (b, idx, value) & ~(bit_mask (start) - 1);
+	while (elem == 0) {
+		if (++idx * ELEM_BITS >= limit)
+			return limit;
+		elem = elem_for (b, idx, value);
+	}
+	start = idx * ELEM_BITS + __builtin_ctzl (elem);
+	return start < limit ? start : limit;
+}
+
 /* Sets all bits in B to VALUE. */
 void
 bitmap_set_all (struct bitmap *b, bool value) {
@@ -194,17 +264,32 @@ bitmap_set_all (struct bitmap *b, bool value) {
 	bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE, an element
+   at a time.  Each element is updated atomically. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
+	size_t end = start + cnt;
+	size_t i, next;
 
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		bitmap_set (b, start + i, value);
+	for (i = start; i < end; i = next) {
+		elem_type *elem = &b->bits[elem_idx (i)];
+		elem_type mask;
+
+		next = (elem_idx (i) + 1) * ELEM_BITS;
+		if (next > end)
+			next = end;
+		mask = range_mask (i, next);
+		if (value)
+			asm ("lock orq %1, %0" : "=m" (*elem) : "r" (mask) : "cc");
+		else
+			asm ("lock andq %1, %0" : "=m" (*elem) : "r" (~mask) : "cc");
+	}
+	if (!value && cnt > 0)
+		note_clear (b, start);
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -218,9 +303,14 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
 	ASSERT (start + cnt <= b->bit_cnt);
 
 	value_cnt = 0;
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			value_cnt++;
+	for (i = start; i < start + cnt; ) {
+		size_t next = (elem_idx (i) + 1) * ELEM_BITS;
+		if (next > start + cnt)
+			next = start + cnt;
+		value_cnt += popcount (elem_for (b, elem_idx (i), value)
+				& range_mask (i, next));
+		i = next;
+	}
 	return value_cnt;
 }
 
@@ -234,10 +324,8 @@ bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) {
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			return true;
-	return false;
+	i = next_bit (b, start, start + cnt, value);
+	return i < start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -263,23 +351,47 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt) {
 
 /* Finding set or unset bits. */
 
+/* Does the work of bitmap_scan(), and also stores in *FIRST the
+   index of the first bit at or after START that is set to VALUE,
+   or the size of B if there is none.  When searching for false
+   bits, skips to HINT, below which none may be.  Each candidate
+   group starts at a bit set to VALUE and ends at the next bit
+   that is not, so the search moves a group at a time rather than
+   a bit at a time. */
+static size_t
+scan (const struct bitmap *b, size_t start, size_t cnt, bool value,
+		size_t hint, size_t *first) {
+	size_t i;
+
+	ASSERT (b != NULL);
+	ASSERT (start <= b->bit_cnt);
+
+	if (cnt == 0) {
+		*first = start;
+		return start;
+	}
+
+	if (!value && start < hint)
+		start = hint;
+
+	i = *first = next_bit (b, start, b->bit_cnt, value);
+	while (cnt <= b->bit_cnt - i) {
+		size_t end = next_bit (b, i, i + cnt, !value);
+		if (end == i + cnt)
+			return i;
+		i = next_bit (b, end, b->bit_cnt, value);
+	}
+	return BITMAP_ERROR;
+}
+
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
    If there is no such group, returns BITMAP_ERROR. */
 size_t
 bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	ASSERT (b != NULL);
-	ASSERT (start <= b->bit_cnt);
-
-	if (cnt <= b->bit_cnt) {
-		size_t last = b->bit_cnt - cnt;
-		size_t i;
-		for (i = start; i <= last; i++)
-			if (!bitmap_contains (b, i, cnt, !value))
-				return i;
-	}
-	return BITMAP_ERROR;
+	size_t first;
+	return scan (b, start, cnt, value, b->clear_hint, &first);
 }
 
 /* Finds the first group of CNT consecutive bits in B at or after
@@ -291,9 +403,25 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
    setting them. */
 size_t
 bitmap_scan_and_flip (struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t idx = bitmap_scan (b, start, cnt, value);
+	unsigned seq = b->clear_seq;
+	size_t hint = b->clear_hint;
+	size_t first;
+	size_t idx = scan (b, start, cnt, value, hint, &first);
+	enum intr_level old_level;
+
 	if (idx != BITMAP_ERROR)
 		bitmap_set_multiple (b, idx, cnt, !value);
+
+	/* Nothing between the hint and FIRST is clear, so allocators
+	   that always scan from the start skip the full prefix next
+	   time.  If bits were cleared since the scan began, that may
+	   no longer be true, so leave the hint where they put it. */
+	if (!value && cnt > 0 && start <= hint) {
+		old_level = intr_disable ();
+		if (b->clear_seq == seq)
+			b->clear_hint = idx == first ? first + cnt : first;
+		intr_set_level (old_level);
+	}
 	return idx;
 }
 
@@ -315,6 +443,7 @@ bitmap_read (struct bitmap *b, struct file *file) {
 		off_t size = byte_cnt (b->bit_cnt);
 		success = file_read_at (file, b->bits, size, 0) == size;
 		b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+		note_clear (b, 0);
 	}
 	return success;
 }
@@ -13,6 +13,7 @@
 	list_entry(LIST_ELEM, struct hash_elem, list_elem)
 
 static struct list *find_bucket (struct hash *, struct hash_elem *);
+static struct list *bucket_for (struct hash *, uint64_t hash);
 static struct hash_elem *find_elem (struct hash *, struct list *,
 		struct hash_elem *);
 static void insert_elem (struct hash *, struct list *, struct hash_elem *);
@@ -235,89 +236,143 @@ hash_empty (struct hash *h) {
 	return h->elem_cnt == 0;
 }
 
-/* Fowler-Noll-Vo hash constants, for 32-bit word sizes. */
-#define FNV_64_PRIME 0x00000100000001B3UL
-#define FNV_64_BASIS 0xcbf29ce484222325UL
+/* The hash functions below take their input a 64-bit word at a
+   time, in the manner of xxHash64: each word is multiplied into
+   the state, which is rotated and multiplied again, and the result
+   goes through a final avalanche step so that every input bit
+   affects the low bits used to pick a bucket. */
+
+/* Multipliers from xxHash64. */
+#define MIX_P1 0x9e3779b185ebca87ULL
+#define MIX_P2 0xc2b2ae3d27d4eb4fULL
+#define MIX_SEED 0x27d4eb2f165667c5ULL
+
+/* Returns X rotated left by R bits. */
+static inline uint64_t
+rotl (uint64_t x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+/* Returns STATE with WORD mixed into it. */
+static inline uint64_t
+mix_word (uint64_t state, uint64_t word) {
+	return rotl (state ^ (word * MIX_P2), 31) * MIX_P1;
+}
+
+/* Returns X with its bits mixed so that each affects every bit of
+   the result (the MurmurHash3 finalizer). */
+static inline uint64_t
+avalanche (uint64_t x) {
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
 
 /* Returns a hash of the SIZE bytes in BUF. */
 uint64_t
 hash_bytes (const void *buf_, size_t size) {
-	/* Fowler-Noll-Vo 32-bit hash, for bytes. */
 	const unsigned char *buf = buf_;
-	uint64_t hash;
+	uint64_t hash, tail;
+	size_t i;
 
 	ASSERT (buf != NULL);
 
-	hash = FNV_64_BASIS;
-	while (size-- > 0)
-		hash = (hash * FNV_64_PRIME) ^ *buf++;
+	hash = MIX_SEED + size;
+	for (; size >= sizeof (uint64_t); size -= sizeof (uint64_t)) {
+		hash = mix_word (hash, *(const uint64_t *) buf);
+		buf += sizeof (uint64_t);
+	}
+	if (size > 0) {
+		tail = 0;
+		for (i = 0; i < size; i++)
+			tail |= (uint64_t) buf[i] << (i * 8);
+		hash = mix_word (hash, tail);
+	}
 
-	return hash;
+	return avalanche (hash);
 }
 
 /* Returns a hash of string S. */
 uint64_t
 hash_string (const char *s_) {
 	const unsigned char *s = (const unsigned char *) s_;
-	uint64_t hash;
+	uint64_t hash, word;
+	size_t i;
 
 	ASSERT (s != NULL);
 
-	hash = FNV_64_BASIS;
-	while (*s != '\0')
-		hash = (hash * FNV_64_PRIME) ^ *s++;
+	hash = MIX_SEED;
+	do {
+		word = 0;
+		for (i = 0; i < sizeof word && s[i] != '\0'; i++)
+			word |= (uint64_t) s[i] << (i * 8);
+		hash = mix_word (hash, word);
+		s += i;
+	} while (i == sizeof word);
 
-	return hash;
+	return avalanche (hash);
 }
 
 /* Returns a hash of integer I. */
 uint64_t
 hash_int (int i) {
-	return hash_bytes (&i, sizeof i);
+	return avalanche ((uint64_t) i * MIX_P1);
+}
+
+/* Returns a hash of pointer P.  P itself is the key, not what it
+   points to. */
+uint64_t
+hash_ptr (const void *p) {
+	return avalanche ((uintptr_t) p * MIX_P1);
 }
 
-/* Returns the bucket in H that E belongs in. */
+/* Returns the bucket in H for hash value HASH. */
+static struct list *
+bucket_for (struct hash *h, uint64_t hash) {
+	return &h->buckets[hash & (h->bucket_cnt - 1)];
+}
+
+/* Computes E's hash value, saving it in E, and returns the bucket
+   in H that E belongs in. */
 static struct list *
 find_bucket (struct hash *h, struct hash_elem *e) {
-	size_t bucket_idx = h->hash (e, h->aux) & (h->bucket_cnt - 1);
-	return &h->buckets[bucket_idx];
+	e->hash = h->hash (e, h->aux);
+	return bucket_for (h, e->hash);
 }
 
-/* Searches BUCKET in H for a hash element equal to E.  Returns
-   it if found or a null pointer otherwise. */
+/* Searches BUCKET in H for a hash element equal to E, whose hash
+   value find_bucket() has saved.  Returns it if found or a null
+   pointer otherwise.  Elements with a different hash value are
+   passed over without calling the comparison function. */
 static struct hash_elem *
 find_elem (struct hash *h, struct list *bucket, struct hash_elem *e) {
 	struct list_elem *i;
 
 	for (i = list_begin (bucket); i != list_end (bucket); i = list_next (i)) {
 		struct hash_elem *hi = list_elem_to_hash_elem (i);
-		if (!h->less (hi, e, h->aux) && !h->less (e, hi, h->aux))
+		if (hi->hash == e->hash
+				&& !h->less (hi, e, h->aux) && !h->less (e, hi, h->aux))
 			return hi;
 	}
 	return NULL;
 }
 
-/* Returns X with its lowest-order bit set to 1 turned off. */
-static inline size_t
-turn_off_least_1bit (size_t x) {
-	return x & (x - 1);
-}
-
-/* Returns true if X is a power of 2, otherwise false. */
-static inline size_t
-is_power_of_2 (size_t x) {
-	return x != 0 && turn_off_least_1bit (x) == 0;
-}
-
 /* Element per bucket ratios. */
 #define MIN_ELEMS_PER_BUCKET  1 /* Elems/bucket < 1: reduce # of buckets. */
 #define BEST_ELEMS_PER_BUCKET 2 /* Ideal elems/bucket. */
 #define MAX_ELEMS_PER_BUCKET  4 /* Elems/bucket > 4: increase # of buckets. */
 
 /* Changes the number of buckets in hash table H to match the
-   ideal.  This function can fail because of an out-of-memory
-   condition, but that'll just make hash accesses less efficient;
-   we can still continue. */
+   ideal, if H has drifted outside the MIN_ELEMS_PER_BUCKET to
+   MAX_ELEMS_PER_BUCKET range.  The gap between the two means that
+   a table whose size hovers around a boundary is not rebuilt on
+   every insertion and deletion, so the cost of rebuilding is
+   spread over many operations.  This function can fail because of
+   an out-of-memory condition, but that'll just make hash accesses
+   less efficient; we can still continue. */
 static void
 rehash (struct hash *h) {
 	size_t old_bucket_cnt, new_bucket_cnt;
@@ -330,15 +385,18 @@ rehash (struct hash *h) {
 	old_buckets = h->buckets;
 	old_bucket_cnt = h->bucket_cnt;
 
+	if (h->elem_cnt <= old_bucket_cnt * MAX_ELEMS_PER_BUCKET
+			&& (h->elem_cnt >= old_bucket_cnt * MIN_ELEMS_PER_BUCKET
+				|| old_bucket_cnt == 4))
+		return;
+
 	/* Calculate the number of buckets to use now.
 	   We want one bucket for about every BEST_ELEMS_PER_BUCKET.
 	   We must have at least four buckets, and the number of
 	   buckets must be a power of 2. */
-	new_bucket_cnt = h->elem_cnt / BEST_ELEMS_PER_BUCKET;
-	if (new_bucket_cnt < 4)
-		new_bucket_cnt = 4;
-	while (!is_power_of_2 (new_bucket_cnt))
-		new_bucket_cnt = turn_off_least_1bit (new_bucket_cnt);
+	new_bucket_cnt = 4;
+	while (new_bucket_cnt * BEST_ELEMS_PER_BUCKET < h->elem_cnt)
+		new_bucket_cnt *= 2;
 
 	/* Don't do anything if the bucket count wouldn't change. */
 	if (new_bucket_cnt == old_bucket_cnt)
@@ -368,7 +426,7 @@ rehash (struct hash *h) {
 		for (elem = list_begin (old_bucket);
 				elem != list_end (old_bucket); elem = next) {
 			struct list *new_bucket
-				= find_bucket (h, list_elem_to_hash_elem (elem));
+				= bucket_for (h, list_elem_to_hash_elem (elem)->hash);
 			next = list_next (elem);
 			list_remove (elem);
 			list_push_front (new_bucket, elem);
@@ -0,0 +1,283 @@
+/* Open-addressing hash table.
+
+   See ohash.h for basic information. */
+
+#include "ohash.h"
+#include "../debug.h"
+#include "threads/malloc.h"
+
+/* Fewest slots a table has. */
+#define MIN_SLOTS 8
+
+static struct ohash_slot *find_slot (struct ohash *, struct hash_elem *,
+		uint64_t hash);
+static bool insert_slot (struct ohash *, struct hash_elem *, uint64_t hash);
+static void remove_slot (struct ohash *, struct ohash_slot *);
+static void resize (struct ohash *, size_t slot_cnt);
+
+/* Initializes hash table H to compute hash values using HASH and
+   compare hash elements using LESS, given auxiliary data AUX. */
+bool
+ohash_init (struct ohash *h,
+		hash_hash_func *hash, hash_less_func *less, void *aux) {
+	h->elem_cnt = 0;
+	h->slot_cnt = MIN_SLOTS;
+	h->slots = calloc (h->slot_cnt, sizeof *h->slots);
+	h->hash = hash;
+	h->less = less;
+	h->aux = aux;
+	return h->slots != NULL;
+}
+
+/* Removes all the elements from H.
+
+   If DESTRUCTOR is non-null, then it is called for each element
+   in the hash.  DESTRUCTOR may, if appropriate, deallocate the
+   memory used by the hash element.  However, modifying hash
+   table H while ohash_clear() is running, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), or ohash_delete(), yields undefined behavior,
+   whether done in DESTRUCTOR or elsewhere. */
+void
+ohash_clear (struct ohash *h, hash_action_func *destructor) {
+	size_t i;
+
+	for (i = 0; i < h->slot_cnt; i++) {
+		struct hash_elem *e = h->slots[i].elem;
+		h->slots[i].elem = NULL;
+		if (e != NULL && destructor != NULL)
+			destructor (e, h->aux);
+	}
+	h->elem_cnt = 0;
+}
+
+/* Destroys hash table H.
+
+   If DESTRUCTOR is non-null, then it is first called for each
+   element in the hash, as in ohash_clear(). */
+void
+ohash_destroy (struct ohash *h, hash_action_func *destructor) {
+	if (destructor != NULL)
+		ohash_clear (h, destructor);
+	free (h->slots);
+}
+
+/* Inserts NEW into hash table H and returns a null pointer, if
+   no equal element is already in the table.
+   If an equal element is already in the table, returns it
+   without inserting NEW.
+   Unlike hash_insert(), this can fail: if H is full and memory
+   to grow it is exhausted, returns NEW without inserting it. */
+struct hash_elem *
+ohash_insert (struct ohash *h, struct hash_elem *new) {
+	uint64_t hash = h->hash (new, h->aux);
+	struct ohash_slot *slot = find_slot (h, new, hash);
+
+	if (slot->elem != NULL)
+		return slot->elem;
+	return insert_slot (h, new, hash) ? NULL : new;
+}
+
+/* Inserts NEW into hash table H, replacing any equal element
+   already in the table, which is returned.
+   Fails like ohash_insert(), returning NEW, only if there was no
+   equal element. */
+struct hash_elem *
+ohash_replace (struct ohash *h, struct hash_elem *new) {
+	uint64_t hash = h->hash (new, h->aux);
+	struct ohash_slot *slot = find_slot (h, new, hash);
+	struct hash_elem *old = slot->elem;
+
+	if (old != NULL)
+		slot->elem = new;
+	else if (!insert_slot (h, new, hash))
+		return new;
+	return old;
+}
+
+/* Finds and returns an element equal to E in hash table H, or a
+   null pointer if no equal element exists in the table. */
+struct hash_elem *
+ohash_find (struct ohash *h, struct hash_elem *e) {
+	return find_slot (h, e, h->hash (e, h->aux))->elem;
+}
+
+/* Finds, removes, and returns an element equal to E in hash
+   table H.  Returns a null pointer if no equal element existed
+   in the table.
+
+   If the elements of the hash table are dynamically allocated,
+   or own resources that are, then it is the caller's
+   responsibility to deallocate them. */
+struct hash_elem *
+ohash_delete (struct ohash *h, struct hash_elem *e) {
+	struct ohash_slot *slot = find_slot (h, e, h->hash (e, h->aux));
+	struct hash_elem *found = slot->elem;
+
+	if (found != NULL) {
+		remove_slot (h, slot);
+		if (h->slot_cnt > MIN_SLOTS && h->elem_cnt < h->slot_cnt / 8)
+			resize (h, h->slot_cnt / 2);
+	}
+	return found;
+}
+
+/* Calls ACTION for each element in hash table H in arbitrary
+   order.
+   Modifying hash table H while ohash_apply() is running, using
+   any of the functions ohash_clear(), ohash_destroy(),
+   ohash_insert(), ohash_replace(), or ohash_delete(), yields
+   undefined behavior, whether done from ACTION or elsewhere. */
+void
+ohash_apply (struct ohash *h, hash_action_func *action) {
+	size_t i;
+
+	ASSERT (action != NULL);
+
+	for (i = 0; i < h->slot_cnt; i++)
+		if (h->slots[i].elem != NULL)
+			action (h->slots[i].elem, h->aux);
+}
+
+/* Initializes I for iterating hash table H, with the same idiom
+   as hash_first().
+
+   Modifying hash table H during iteration, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), or ohash_delete(), invalidates all
+   iterators. */
+void
+ohash_first (struct ohash_iterator *i, struct ohash *h) {
+	ASSERT (i != NULL);
+	ASSERT (h != NULL);
+
+	i->hash = h;
+	i->slot = NULL;
+}
+
+/* Advances I to the next element in the hash table and returns
+   it.  Returns a null pointer if no elements are left.  Elements
+   are returned in arbitrary order. */
+struct hash_elem *
+ohash_next (struct ohash_iterator *i) {
+	struct ohash_slot *end;
+
+	ASSERT (i != NULL);
+
+	end = i->hash->slots + i->hash->slot_cnt;
+	i->slot = i->slot == NULL ? i->hash->slots : i->slot + 1;
+	while (i->slot < end && i->slot->elem == NULL)
+		i->slot++;
+	return ohash_cur (i);
+}
+
+/* Returns the current element in the hash table iteration, or a
+   null pointer at the end of the table.  Undefined behavior
+   after calling ohash_first() but before ohash_next(). */
+struct hash_elem *
+ohash_cur (struct ohash_iterator *i) {
+	if (i->slot >= i->hash->slots + i->hash->slot_cnt)
+		return NULL;
+	return i->slot->elem;
+}
+
+/* Returns the number of elements in H. */
+size_t
+ohash_size (struct ohash *h) {
+	return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+ohash_empty (struct ohash *h) {
+	return h->elem_cnt == 0;
+}
+
+/* Returns the slot in H holding an element equal to E, whose hash
+   value is HASH, or the empty slot where E would go if there is
+   none. */
+static struct ohash_slot *
+find_slot (struct ohash *h, struct hash_elem *e, uint64_t hash) {
+	size_t mask = h->slot_cnt - 1;
+	size_t i;
+
+	for (i = hash & mask; h->slots[i].elem != NULL; i = (i + 1) & mask) {
+		struct ohash_slot *slot = &h->slots[i];
+		if (slot->hash == hash
+				&& !h->less (slot->elem, e, h->aux)
+				&& !h->less (e, slot->elem, h->aux))
+			return slot;
+	}
+	return &h->slots[i];
+}
+
+/* Puts E, whose hash value is HASH and which is not yet in H,
+   into H, growing H first if it is three quarters full.  Growing
+   can fail for lack of memory, which only makes searches slower,
+   until no empty slot would be left.  Then returns false without
+   inserting E, and otherwise true. */
+static bool
+insert_slot (struct ohash *h, struct hash_elem *e, uint64_t hash) {
+	size_t mask, i;
+
+	if ((h->elem_cnt + 1) * 4 > h->slot_cnt * 3)
+		resize (h, h->slot_cnt * 2);
+	if (h->elem_cnt + 1 >= h->slot_cnt)
+		return false;
+
+	mask = h->slot_cnt - 1;
+	for (i = hash & mask; h->slots[i].elem != NULL; i = (i + 1) & mask)
+		continue;
+	h->slots[i].hash = hash;
+	h->slots[i].elem = e;
+	h->elem_cnt++;
+	return true;
+}
+
+/* Empties SLOT in H, then moves back each later element in the
+   same run that would otherwise become unreachable. */
+static void
+remove_slot (struct ohash *h, struct ohash_slot *slot) {
+	size_t mask = h->slot_cnt - 1;
+	size_t hole = slot - h->slots;
+	size_t i;
+
+	for (i = (hole + 1) & mask; h->slots[i].elem != NULL; i = (i + 1) & mask) {
+		/* The element in slot I may fill the hole only if its
+		   home slot is not between the hole and I. */
+		size_t home = h->slots[i].hash & mask;
+		if (((i - home) & mask) >= ((i - hole) & mask)) {
+			h->slots[hole] = h->slots[i];
+			hole = i;
+		}
+	}
+	h->slots[hole].elem = NULL;
+	h->elem_cnt--;
+}
+
+/* Moves H's elements into a new array of SLOT_CNT slots.  On
+   failure to allocate it, leaves H as it is. */
+static void
+resize (struct ohash *h, size_t slot_cnt) {
+	struct ohash_slot *old_slots = h->slots;
+	size_t old_slot_cnt = h->slot_cnt;
+	size_t i, j, mask;
+
+	h->slots = calloc (slot_cnt, sizeof *h->slots);
+	if (h->slots == NULL) {
+		h->slots = old_slots;
+		return;
+	}
+	h->slot_cnt = slot_cnt;
+
+	mask = slot_cnt - 1;
+	for (i = 0; i < old_slot_cnt; i++) {
+		if (old_slots[i].elem == NULL)
+			continue;
+		for (j = old_slots[i].hash & mask; h->slots[j].elem != NULL;
+				j = (j + 1) & mask)
+			continue;
+		h->slots[j] = old_slots[i];
+	}
+	free (old_slots);
+}
@@ -1,5 +1,83 @@
 #include <string.h>
 #include <debug.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The block functions below move a word at a time once the
+   destination is aligned, and the unaligned source or compared
+   words cost little on x86.  Copies and fills of at least
+   REP_MIN bytes use "rep movsb" and "rep stosb" instead if the CPU
+   has enhanced REP MOVSB/STOSB (ERMS), which makes them the
+   fastest way to move large blocks. */
+
+/* Bytes in a word. */
+#define WORD_SIZE sizeof (uint64_t)
+
+/* Smallest block worth a "rep" instruction's start-up cost. */
+#define REP_MIN 256
+
+/* True if "rep movsb" and "rep stosb" are fast, set by
+   string_init(). */
+static bool use_rep;
+
+/* Chooses how the block functions work on this CPU.  Until it is
+   called they use word loops, which work everywhere. */
+void
+string_init (void) {
+	uint32_t eax, ebx, ecx, edx;
+
+	asm volatile ("cpuid"
+			: "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+			: "a" (0));
+	if (eax < 7)
+		return;
+	asm volatile ("cpuid"
+			: "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+			: "a" (7), "c" (0));
+	use_rep = (ebx & (1 << 9)) != 0;
+}
+
+/* Returns the word at P, which need not be aligned. */
+static inline uint64_t
+load_word (const unsigned char *p) {
+	return *(const uint64_t *) p;
+}
+
+/* Copies SIZE bytes forward from SRC to DST, which may overlap
+   only if DST is below SRC. */
+static void
+copy_forward (unsigned char *dst, const unsigned char *src, size_t size) {
+	while (size > 0 && (uintptr_t) dst % WORD_SIZE != 0) {
+		*dst++ = *src++;
+		size--;
+	}
+	for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+		*(uint64_t *) dst = load_word (src);
+		dst += WORD_SIZE;
+		src += WORD_SIZE;
+	}
+	while (size-- > 0)
+		*dst++ = *src++;
+}
+
+/* Copies SIZE bytes backward from the ends of SRC and DST, which
+   may overlap only if DST is above SRC. */
+static void
+copy_backward (unsigned char *dst, const unsigned char *src, size_t size) {
+	dst += size;
+	src += size;
+	while (size > 0 && (uintptr_t) dst % WORD_SIZE != 0) {
+		*--dst = *--src;
+		size--;
+	}
+	for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+		dst -= WORD_SIZE;
+		src -= WORD_SIZE;
+		*(uint64_t *) dst = load_word (src);
+	}
+	while (size-- > 0)
+		*--dst = *--src;
+}
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -11,8 +89,11 @@ memcpy (void *dst_, const void *src_, size_t size) {
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
-	while (size-- > 0)
-		*dst++ = *src++;
+	if (use_rep && size >= REP_MIN)
+		asm volatile ("rep movsb"
+				: "+D" (dst), "+S" (src), "+c" (size) : : "memory");
+	else
+		copy_forward (dst, src, size);
 
 	return dst_;
 }
@@ -27,17 +108,12 @@ memmove (void *dst_, const void *src_, size_t size) {
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
-	if (dst < src) {
-		while (size-- > 0)
-			*dst++ = *src++;
-	} else {
-		dst += size;
-		src += size;
-		while (size-- > 0)
-			*--dst = *--src;
-	}
+	if (dst < src)
+		copy_forward (dst, src, size);
+	else
+		copy_backward (dst, src, size);
 
-	return dst;
+	return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -52,6 +128,13 @@ memcmp (const void *a_, const void *b_, size_t size) {
 	ASSERT (a != NULL || size == 0);
 	ASSERT (b != NULL || size == 0);
 
+	/* Skip equal words, then find the byte that differs. */
+	for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+		if (load_word (a) != load_word (b))
+			break;
+		a += WORD_SIZE;
+		b += WORD_SIZE;
+	}
 	for (; size-- > 0; a++, b++)
 		if (*a != *b)
 			return *a > *b ? +1 : -1;
@@ -257,9 +340,25 @@ strtok_r (char *s, const char *delimiters, char **save_ptr) {
 void *
 memset (void *dst_, int value, size_t size) {
 	unsigned char *dst = dst_;
+	uint64_t word;
 
 	ASSERT (dst != NULL || size == 0);
 
+	if (use_rep && size >= REP_MIN) {
+		asm volatile ("rep stosb"
+				: "+D" (dst), "+c" (size) : "a" (value) : "memory");
+		return dst_;
+	}
+
+	while (size > 0 && (uintptr_t) dst % WORD_SIZE != 0) {
+		*dst++ = value;
+		size--;
+	}
+	word = (unsigned char) value * 0x0101010101010101ULL;
+	for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+		*(uint64_t *) dst = word;
+		dst += WORD_SIZE;
+	}
 	while (size-- > 0)
 		*dst++ = value;
 
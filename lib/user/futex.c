@@ -0,0 +1,84 @@
+#include <futex.h>
+#include <limits.h>
+#include <syscall.h>
+
+/* Mutex states. */
+#define UNLOCKED 0
+#define LOCKED 1
+#define CONTENDED 2             /* Locked, and there may be waiters. */
+
+/* Initializes MUTEX as unlocked. */
+void
+mutex_init (struct mutex *mutex) {
+	mutex->state = UNLOCKED;
+}
+
+/* Takes MUTEX from unlocked to CONTENDED, sleeping until it is
+   unlocked.  Taking it as CONTENDED rather than LOCKED is
+   conservative: it costs the next unlock a system call even if
+   nobody else is waiting, but never loses a wakeup. */
+static void
+lock_contended (struct mutex *mutex) {
+	while (__atomic_exchange_n (&mutex->state, CONTENDED, __ATOMIC_ACQUIRE)
+			!= UNLOCKED)
+		futex_wait (&mutex->state, CONTENDED);
+}
+
+/* Acquires MUTEX, sleeping until it is available. */
+void
+mutex_lock (struct mutex *mutex) {
+	if (!mutex_trylock (mutex))
+		lock_contended (mutex);
+}
+
+/* Acquires MUTEX if it is available without waiting.  Returns true
+   if successful. */
+bool
+mutex_trylock (struct mutex *mutex) {
+	int state = UNLOCKED;
+	return __atomic_compare_exchange_n (&mutex->state, &state, LOCKED, false,
+			__ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+/* Releases MUTEX, waking one waiter if there may be any. */
+void
+mutex_unlock (struct mutex *mutex) {
+	if (__atomic_exchange_n (&mutex->state, UNLOCKED, __ATOMIC_RELEASE)
+			== CONTENDED)
+		futex_wake (&mutex->state, 1);
+}
+
+/* Initializes COND. */
+void
+condvar_init (struct condvar *cond) {
+	cond->seq = 0;
+}
+
+/* Atomically releases MUTEX and waits for COND to be signaled,
+   then reacquires MUTEX before returning.  As with the kernel's
+   condition variables, the condition must be rechecked after
+   waking. */
+void
+condvar_wait (struct condvar *cond, struct mutex *mutex) {
+	int seq = __atomic_load_n (&cond->seq, __ATOMIC_RELAXED);
+
+	mutex_unlock (mutex);
+	futex_wait (&cond->seq, seq);
+
+	/* Other waiters may have been woken too. */
+	lock_contended (mutex);
+}
+
+/* Wakes one thread waiting on COND, if any. */
+void
+condvar_signal (struct condvar *cond) {
+	__atomic_fetch_add (&cond->seq, 1, __ATOMIC_RELEASE);
+	futex_wake (&cond->seq, 1);
+}
+
+/* Wakes every thread waiting on COND. */
+void
+condvar_broadcast (struct condvar *cond) {
+	__atomic_fetch_add (&cond->seq, 1, __ATOMIC_RELEASE);
+	futex_wake (&cond->seq, INT_MAX);
+}
@@ -0,0 +1,281 @@
+#include <malloc.h>
+#include <debug.h>
+#include <futex.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+
+/* A user heap allocator.
+
+   Requests of up to MAX_SMALL bytes are rounded up to a power of two
+   and served from pages dedicated to that size class.  Free blocks
+   of each class are kept in per-thread arenas, so allocating and
+   freeing a small block normally takes an uncontended lock and no
+   system call.  Larger requests get whole pages of their own.
+
+   Pages come from the heap that sbrk() grows.  Whole-page blocks
+   are kept for reuse when freed, or given back to the kernel when
+   they lie at the top of the heap.  There is no mmap() to fall back
+   on. */
+
+#define PAGE_SIZE 4096
+
+/* Size classes: 16, 32, 64, ..., MAX_SMALL bytes. */
+#define MIN_SMALL 16
+#define CLASS_CNT 7
+#define MAX_SMALL (MIN_SMALL << (CLASS_CNT - 1))
+#define LARGE CLASS_CNT                 /* Class of whole-page blocks. */
+
+/* Number of arenas.  Threads run on stacks STACK_SPAN bytes apart,
+   so picking the arena by stack address usually gives each thread
+   its own. */
+#define ARENA_CNT 8
+#define STACK_SPAN 0x10000
+
+/* Header at the start of every page of small blocks, and of the
+   first page of every large block. */
+struct page_hdr {
+	uint32_t magic;             /* Detects bad pointers. */
+	uint32_t class;             /* Size class, or LARGE. */
+	size_t pages;               /* Pages in a large block. */
+};
+
+#define PAGE_MAGIC 0x6d616c6c
+
+/* A free small block. */
+struct free_block {
+	struct free_block *next;
+};
+
+/* Free small blocks, one list per size class. */
+struct arena {
+	struct mutex lock;
+	struct free_block *free[CLASS_CNT];
+};
+
+/* A run of free pages. */
+struct free_run {
+	struct free_run *next;
+	size_t pages;
+};
+
+static struct arena arenas[ARENA_CNT];
+static struct free_run *free_runs;
+static struct mutex page_lock = MUTEX_INITIALIZER;
+
+/* Returns the arena for the running thread. */
+static struct arena *
+arena_current (void) {
+	uintptr_t sp = (uintptr_t) __builtin_frame_address (0);
+	return &arenas[sp / STACK_SPAN % ARENA_CNT];
+}
+
+/* Returns the header of the page that holds block P. */
+static struct page_hdr *
+page_of (void *p) {
+	struct page_hdr *h = (struct page_hdr *) ((uintptr_t) p & ~(PAGE_SIZE - 1));
+	ASSERT (h->magic == PAGE_MAGIC);
+	return h;
+}
+
+/* Returns CNT contiguous pages, or a null pointer if the heap
+   cannot grow. */
+static void *
+get_pages (size_t cnt) {
+	struct free_run **rp, *run;
+	uintptr_t brk;
+	void *p = NULL;
+
+	mutex_lock (&page_lock);
+	for (rp = &free_runs; *rp != NULL; rp = &(*rp)->next)
+		if ((*rp)->pages >= cnt) {
+			run = *rp;
+			if (run->pages == cnt)
+				*rp = run->next;
+			else {
+				struct free_run *rest =
+					(struct free_run *) ((uint8_t *) run + cnt * PAGE_SIZE);
+				rest->next = run->next;
+				rest->pages = run->pages - cnt;
+				*rp = rest;
+			}
+			p = run;
+			break;
+		}
+	if (p == NULL) {
+		/* Keep the break page-aligned, in case the program moved it
+		   itself. */
+		brk = (uintptr_t) sbrk (0);
+		if (brk % PAGE_SIZE == 0
+				|| sbrk (ROUND_UP (brk, PAGE_SIZE) - brk) != (void *) -1)
+			p = sbrk (cnt * PAGE_SIZE);
+		if (p == (void *) -1)
+			p = NULL;
+	}
+	mutex_unlock (&page_lock);
+	return p;
+}
+
+/* Frees the CNT pages at P. */
+static void
+put_pages (void *p, size_t cnt) {
+	struct free_run *run = p;
+
+	mutex_lock (&page_lock);
+	if ((uint8_t *) p + cnt * PAGE_SIZE == sbrk (0))
+		sbrk (-(intptr_t) (cnt * PAGE_SIZE));
+	else {
+		run->pages = cnt;
+		run->next = free_runs;
+		free_runs = run;
+	}
+	mutex_unlock (&page_lock);
+}
+
+/* Returns the size class for a SIZE-byte small block. */
+static unsigned
+size_class (size_t size) {
+	unsigned class = 0;
+
+	while ((size_t) MIN_SMALL << class < size)
+		class++;
+	return class;
+}
+
+/* Returns a new page carved into blocks of CLASS, with the first
+   block returned and the rest added to arena A. */
+static void *
+refill (struct arena *a, unsigned class) {
+	size_t size = (size_t) MIN_SMALL << class;
+	struct page_hdr *h = get_pages (1);
+	uint8_t *first, *b;
+
+	if (h == NULL)
+		return NULL;
+	h->magic = PAGE_MAGIC;
+	h->class = class;
+	h->pages = 1;
+
+	/* The header takes the place of the first block, so the others
+	   stay aligned to their size. */
+	first = (uint8_t *) h + size;
+	mutex_lock (&a->lock);
+	for (b = first + size; b + size <= (uint8_t *) h + PAGE_SIZE; b += size) {
+		struct free_block *fb = (struct free_block *) b;
+		fb->next = a->free[class];
+		a->free[class] = fb;
+	}
+	mutex_unlock (&a->lock);
+	return first;
+}
+
+/* Obtains and returns a new block of at least SIZE bytes.
+   Returns a null pointer if memory is not available. */
+void *
+malloc (size_t size) {
+	struct arena *a;
+	struct free_block *b;
+	unsigned class;
+
+	if (size == 0)
+		return NULL;
+
+	if (size > MAX_SMALL) {
+		size_t pages = DIV_ROUND_UP (size + sizeof (struct page_hdr), PAGE_SIZE);
+		struct page_hdr *h = get_pages (pages);
+		if (h == NULL)
+			return NULL;
+		h->magic = PAGE_MAGIC;
+		h->class = LARGE;
+		h->pages = pages;
+		return h + 1;
+	}
+
+	class = size_class (size);
+	a = arena_current ();
+	mutex_lock (&a->lock);
+	b = a->free[class];
+	if (b != NULL)
+		a->free[class] = b->next;
+	mutex_unlock (&a->lock);
+	return b != NULL ? b : refill (a, class);
+}
+
+/* Allocates and returns A times B bytes initialized to zeroes.
+   Returns a null pointer if memory is not available. */
+void *
+calloc (size_t a, size_t b) {
+	void *p;
+	size_t size;
+
+	size = a * b;
+	if (size < a || size < b)
+		return NULL;
+
+	p = malloc (size);
+	if (p != NULL)
+		memset (p, 0, size);
+	return p;
+}
+
+/* Returns the number of bytes usable in block P. */
+static size_t
+block_size (void *p) {
+	struct page_hdr *h = page_of (p);
+	if (h->class == LARGE)
+		return h->pages * PAGE_SIZE - sizeof *h;
+	return (size_t) MIN_SMALL << h->class;
+}
+
+/* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly moving
+   it in the process.  Returns the new block if successful, or a
+   null pointer on failure, in which case OLD_BLOCK is unchanged.
+   A call with null OLD_BLOCK is equivalent to malloc (NEW_SIZE),
+   and one with zero NEW_SIZE to free (OLD_BLOCK). */
+void *
+realloc (void *old_block, size_t new_size) {
+	void *new_block;
+	size_t old_size;
+
+	if (new_size == 0) {
+		free (old_block);
+		return NULL;
+	}
+	if (old_block == NULL)
+		return malloc (new_size);
+
+	old_size = block_size (old_block);
+	if (new_size <= old_size)
+		return old_block;
+	new_block = malloc (new_size);
+	if (new_block != NULL) {
+		memcpy (new_block, old_block, old_size);
+		free (old_block);
+	}
+	return new_block;
+}
+
+/* Frees block P, which must have been previously allocated with
+   malloc(), calloc(), or realloc(). */
+void
+free (void *p) {
+	struct page_hdr *h;
+	struct arena *a;
+	struct free_block *b = p;
+
+	if (p == NULL)
+		return;
+	h = page_of (p);
+	if (h->class == LARGE) {
+		put_pages (h, h->pages);
+		return;
+	}
+	ASSERT (h->class < CLASS_CNT);
+
+	a = arena_current ();
+	mutex_lock (&a->lock);
+	b->next = a->free[h->class];
+	a->free[h->class] = b;
+	mutex_unlock (&a->lock);
+}
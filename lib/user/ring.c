@@ -0,0 +1,35 @@
+#include <ring.h>
+#include <syscall.h>
+
+/* Returns the next free submission slot in RING, queued to run at
+   the next ring_submit(), or a null pointer if the submission
+   queue is full. */
+struct ring_sqe *
+ring_get_sqe (struct ring *ring) {
+	if (ring->sq_tail - ring->sq_head >= ring->entries)
+		return NULL;
+	return &ring->sq[ring->sq_tail++ & (ring->entries - 1)];
+}
+
+/* Runs every request queued in RING.  Returns the number of
+   requests run, which is less than the number queued if the
+   completion queue filled up. */
+int
+ring_submit (struct ring *ring) {
+	return ring_enter (ring->sq_tail - ring->sq_head);
+}
+
+/* Returns the oldest unreaped completion in RING, or a null
+   pointer if there is none. */
+struct ring_cqe *
+ring_peek_cqe (struct ring *ring) {
+	if (ring->cq_head == ring->cq_tail)
+		return NULL;
+	return &ring->cq[ring->cq_head & (ring->entries - 1)];
+}
+
+/* Marks the completion returned by ring_peek_cqe() as reaped. */
+void
+ring_cqe_seen (struct ring *ring) {
+	ring->cq_head++;
+}
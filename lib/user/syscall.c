@@ -25,7 +25,7 @@ static __inline int64_t syscall (uint64_t num_, uint64_t a1_, uint64_t a2_,
 			"syscall\n"
 			: "=a" (ret)
 			: "g" (num), "g" (a1), "g" (a2), "g" (a3), "g" (a4), "g" (a5), "g" (a6)
-			: "cc", "memory");
+			: "rcx", "r11", "cc", "memory");
 	return ret;
 }
 
@@ -54,7 +54,7 @@ static __inline int64_t syscall (uint64_t num_, uint64_t a1_, uint64_t a2_,
 			((uint64_t) ARG2), 0, 0, 0))
 
 #define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3) ( \
-		syscall(((uint64_t *) NUMBER), \
+		syscall(((uint64_t) NUMBER), \
 			((uint64_t) ARG0), \
 			((uint64_t) ARG1), \
 			((uint64_t) ARG2), \
@@ -194,3 +194,93 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+int
+pread (int fd, void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+copy_file_range (int in_fd, int out_fd, unsigned length) {
+	return syscall3 (SYS_COPY_FILE_RANGE, in_fd, out_fd, length);
+}
+
+struct ring *
+ring_setup (unsigned entries) {
+	return (struct ring *) syscall1 (SYS_RING_SETUP, entries);
+}
+
+int
+ring_enter (unsigned to_submit) {
+	return syscall1 (SYS_RING_ENTER, to_submit);
+}
+
+int
+pipe (int fds[2]) {
+	return syscall1 (SYS_PIPE, fds);
+}
+
+int
+splice (int fd_in, int fd_out, unsigned length) {
+	return syscall3 (SYS_SPLICE, fd_in, fd_out, length);
+}
+
+int
+futex_wait (int *addr, int val) {
+	return syscall2 (SYS_FUTEX_WAIT, addr, val);
+}
+
+int
+futex_wake (int *addr, int cnt) {
+	return syscall2 (SYS_FUTEX_WAKE, addr, cnt);
+}
+
+/* Where a new thread starts: runs FUNCTION (AUX) and ends the
+   thread when it returns. */
+static void
+thread_start (void (*function) (void *), void *aux) {
+	function (aux);
+	thread_exit (0);
+}
+
+tid_t
+thread_create (void (*function) (void *), void *aux) {
+	return (tid_t) syscall3 (SYS_THREAD_CREATE, thread_start, function, aux);
+}
+
+int
+thread_join (tid_t tid) {
+	return syscall1 (SYS_THREAD_JOIN, tid);
+}
+
+void
+thread_exit (int status) {
+	syscall1 (SYS_THREAD_EXIT, status);
+	NOT_REACHED ();
+}
+
+void *
+sbrk (intptr_t increment) {
+	return (void *) syscall1 (SYS_SBRK, increment);
+}
+
+pid_t
+spawn (const char *cmd_line, const struct spawn_action *actions,
+		int action_cnt) {
+	return (pid_t) syscall3 (SYS_SPAWN, cmd_line, actions, action_cnt);
+}
@@ -0,0 +1,47 @@
+/* Child process for par-bench.
+   Writes its own file a block at a time, then reads it back and
+   checks the contents. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/filesys/extended/par-bench.h"
+#include "tests/lib.h"
+
+const char *test_name = "child-par-bench";
+
+static char buf[BLOCK_SIZE];
+static char expected[BLOCK_SIZE];
+
+int
+main (int argc, const char *argv[]) 
+{
+  char file_name[16];
+  int child_idx;
+  int fd;
+  int i;
+
+  quiet = true;
+
+  CHECK (argc == 2, "argc must be 2, actually %d", argc);
+  child_idx = atoi (argv[1]);
+  snprintf (file_name, sizeof file_name, "data%d", child_idx);
+  memset (expected, 'a' + child_idx, sizeof expected);
+
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  for (i = 0; i < BLOCK_CNT; i++)
+    CHECK (write (fd, expected, sizeof expected) == sizeof expected,
+           "write \"%s\"", file_name);
+
+  seek (fd, 0);
+  for (i = 0; i < BLOCK_CNT; i++)
+    {
+      CHECK (read (fd, buf, sizeof buf) == sizeof buf,
+             "read \"%s\"", file_name);
+      compare_bytes (buf, expected, sizeof buf, i * sizeof buf, file_name);
+    }
+  close (fd);
+
+  return child_idx;
+}
@@ -0,0 +1,87 @@
+/* Copies a 256 kB file twice, the way tar and cp do, and reports
+   bytes copied per timer tick: once through a user buffer with
+   read and write, and once inside the kernel with
+   copy_file_range. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (256 * 1024)
+#define BUF_SIZE 4096
+
+static char buf[BUF_SIZE];
+static char buf2[BUF_SIZE];
+
+/* Reports the rate of copying FILE_SIZE bytes since START. */
+static void
+report (const char *how, long long start) 
+{
+  long long ticks = get_timer_ticks () - start;
+  msg ("%s: %d bytes in %lld ticks (%lld bytes/tick)", how, FILE_SIZE,
+       ticks, FILE_SIZE / (ticks > 0 ? ticks : 1));
+}
+
+/* Checks that files SRC and DST have the same contents. */
+static void
+compare (const char *src, const char *dst) 
+{
+  int a, b;
+  size_t ofs;
+
+  CHECK ((a = open (src)) > 1, "open \"%s\"", src);
+  CHECK ((b = open (dst)) > 1, "open \"%s\"", dst);
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BUF_SIZE)
+    {
+      if (read (a, buf, BUF_SIZE) != BUF_SIZE
+          || read (b, buf2, BUF_SIZE) != BUF_SIZE)
+        fail ("read at offset %zu failed", ofs);
+      compare_bytes (buf2, buf, BUF_SIZE, ofs, dst);
+    }
+  close (a);
+  close (b);
+}
+
+void
+test_main (void) 
+{
+  long long start;
+  size_t ofs;
+  int in, out;
+  int n;
+
+  CHECK (create ("src", 0), "create \"src\"");
+  CHECK ((out = open ("src")) > 1, "open \"src\"");
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BUF_SIZE)
+    {
+      random_bytes (buf, BUF_SIZE);
+      if (write (out, buf, BUF_SIZE) != BUF_SIZE)
+        fail ("write \"src\" failed");
+    }
+  close (out);
+
+  CHECK (create ("copy1", 0), "create \"copy1\"");
+  CHECK ((in = open ("src")) > 1, "open \"src\"");
+  CHECK ((out = open ("copy1")) > 1, "open \"copy1\"");
+  start = get_timer_ticks ();
+  while ((n = read (in, buf, BUF_SIZE)) > 0)
+    if (write (out, buf, n) != n)
+      fail ("write \"copy1\" failed");
+  report ("read/write", start);
+  close (in);
+  close (out);
+
+  CHECK (create ("copy2", 0), "create \"copy2\"");
+  CHECK ((in = open ("src")) > 1, "open \"src\"");
+  CHECK ((out = open ("copy2")) > 1, "open \"copy2\"");
+  start = get_timer_ticks ();
+  if (copy_file_range (in, out, FILE_SIZE) != FILE_SIZE)
+    fail ("copy_file_range failed");
+  report ("copy_file_range", start);
+  close (in);
+  close (out);
+
+  compare ("src", "copy1");
+  compare ("src", "copy2");
+}
@@ -0,0 +1,38 @@
+/* Opens the same existing file, and tries to open the same
+   missing file, 100,000 times each, reporting the timer ticks
+   taken by each phase.  Repeated lookups of one name should be
+   answered from the dentry cache. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define OPEN_CNT 100000
+
+void
+test_main (void) 
+{
+  const char *file_name = "bench";
+  long long start;
+  int fd;
+  int i;
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+
+  msg ("opening \"%s\" %d times", file_name, OPEN_CNT);
+  start = get_timer_ticks ();
+  for (i = 0; i < OPEN_CNT; i++)
+    {
+      if ((fd = open (file_name)) < 2)
+        fail ("open %d failed", i);
+      close (fd);
+    }
+  msg ("hit: %d opens in %lld ticks", OPEN_CNT, get_timer_ticks () - start);
+
+  msg ("opening \"missing\" %d times", OPEN_CNT);
+  start = get_timer_ticks ();
+  for (i = 0; i < OPEN_CNT; i++)
+    if (open ("missing") != -1)
+      fail ("open %d of \"missing\" succeeded", i);
+  msg ("miss: %d opens in %lld ticks", OPEN_CNT, get_timer_ticks () - start);
+}
@@ -0,0 +1,56 @@
+/* Creates 5,000 files in the root directory, like a much larger
+   grow-dir-lg, then opens and removes each of them, reporting
+   the timer ticks taken by each phase. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 5000
+
+static void
+file_name (char name[16], int i) 
+{
+  snprintf (name, 16, "file%d", i);
+}
+
+void
+test_main (void) 
+{
+  char name[16];
+  long long start;
+  int fd;
+  int i;
+
+  msg ("creating %d files", FILE_CNT);
+  start = get_timer_ticks ();
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      file_name (name, i);
+      if (!create (name, 0))
+        fail ("create \"%s\" failed", name);
+    }
+  msg ("create: %d files in %lld ticks", FILE_CNT, get_timer_ticks () - start);
+
+  msg ("opening %d files", FILE_CNT);
+  start = get_timer_ticks ();
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      file_name (name, i);
+      if ((fd = open (name)) < 2)
+        fail ("open \"%s\" failed", name);
+      close (fd);
+    }
+  msg ("lookup: %d files in %lld ticks", FILE_CNT, get_timer_ticks () - start);
+
+  msg ("removing %d files", FILE_CNT);
+  start = get_timer_ticks ();
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      file_name (name, i);
+      if (!remove (name))
+        fail ("remove \"%s\" failed", name);
+    }
+  msg ("remove: %d files in %lld ticks", FILE_CNT, get_timer_ticks () - start);
+}
@@ -0,0 +1,54 @@
+/* Grows a 1 MB file sequentially, 1,234 bytes at a time, and then
+   reads 512-byte blocks back from random offsets, reporting the
+   timer ticks taken by each phase. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (1024 * 1024)
+#define CHUNK_SIZE 1234
+#define READ_CNT 2000
+
+static char buf[CHUNK_SIZE];
+
+void
+test_main (void) 
+{
+  const char *file_name = "bench";
+  long long start;
+  size_t ofs;
+  int fd;
+  int i;
+
+  random_bytes (buf, sizeof buf);
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+
+  msg ("growing \"%s\" sequentially", file_name);
+  start = get_timer_ticks ();
+  for (ofs = 0; ofs < FILE_SIZE; ofs += CHUNK_SIZE)
+    {
+      size_t block_size = FILE_SIZE - ofs < CHUNK_SIZE ? FILE_SIZE - ofs
+                                                       : CHUNK_SIZE;
+      if (write (fd, buf, block_size) != (int) block_size)
+        fail ("write %zu bytes at offset %zu failed", block_size, ofs);
+    }
+  msg ("grow: %d bytes in %lld ticks", FILE_SIZE, get_timer_ticks () - start);
+  CHECK (filesize (fd) == FILE_SIZE, "filesize \"%s\"", file_name);
+
+  msg ("reading \"%s\" at random offsets", file_name);
+  start = get_timer_ticks ();
+  for (i = 0; i < READ_CNT; i++)
+    {
+      seek (fd, random_ulong () % (FILE_SIZE / 512) * 512);
+      if (read (fd, buf, 512) != 512)
+        fail ("read %d failed", i);
+    }
+  msg ("random read: %d blocks in %lld ticks", READ_CNT,
+       get_timer_ticks () - start);
+
+  msg ("close \"%s\"", file_name);
+  close (fd);
+}
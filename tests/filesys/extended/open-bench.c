@@ -0,0 +1,57 @@
+/* Keeps 10, 60 and then 120 files open and, at each level, times
+   opening and closing one of the files that is already open.
+   Open inodes are looked up by sector, so the cost of each open
+   should not grow with the number of files held open. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 120
+#define OPEN_CNT 10000
+
+static int fds[FILE_CNT];
+
+void
+test_main (void) 
+{
+  static const int levels[] = {10, 60, FILE_CNT};
+  char name[16];
+  size_t l;
+  int i;
+
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      snprintf (name, sizeof name, "file%d", i);
+      if (!create (name, 0))
+        fail ("create \"%s\" failed", name);
+    }
+
+  for (l = 0; l < sizeof levels / sizeof *levels; l++)
+    {
+      int held = levels[l];
+      long long start;
+
+      for (i = 0; i < held; i++)
+        {
+          snprintf (name, sizeof name, "file%d", i);
+          if ((fds[i] = open (name)) < 2)
+            fail ("open \"%s\" failed", name);
+        }
+
+      start = get_timer_ticks ();
+      for (i = 0; i < OPEN_CNT; i++)
+        {
+          int fd = open ("file0");
+          if (fd < 2)
+            fail ("open %d failed", i);
+          close (fd);
+        }
+      msg ("%d held open: %d opens in %lld ticks", held, OPEN_CNT,
+           get_timer_ticks () - start);
+
+      for (i = 0; i < held; i++)
+        close (fds[i]);
+    }
+}
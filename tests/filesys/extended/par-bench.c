@@ -0,0 +1,31 @@
+/* Spawns 16 child processes, each of which writes and then reads
+   back a file of its own, and reports the timer ticks until all
+   of them are done.  Since no two children share a file, their
+   I/O should not serialize in the file system. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/filesys/extended/par-bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  pid_t children[CHILD_CNT];
+  long long start;
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      char file_name[16];
+      snprintf (file_name, sizeof file_name, "data%d", i);
+      CHECK (create (file_name, 0), "create \"%s\"", file_name);
+    }
+
+  start = get_timer_ticks ();
+  exec_children ("child-par-bench", children, CHILD_CNT);
+  wait_children (children, CHILD_CNT);
+  msg ("%d children: %d bytes each in %lld ticks", CHILD_CNT,
+       BLOCK_SIZE * BLOCK_CNT, get_timer_ticks () - start);
+}
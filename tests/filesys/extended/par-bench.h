@@ -0,0 +1,8 @@
+#ifndef TESTS_FILESYS_EXTENDED_PAR_BENCH_H
+#define TESTS_FILESYS_EXTENDED_PAR_BENCH_H
+
+#define CHILD_CNT 16
+#define BLOCK_SIZE 512
+#define BLOCK_CNT 128
+
+#endif /* tests/filesys/extended/par-bench.h */
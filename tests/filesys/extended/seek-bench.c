@@ -0,0 +1,56 @@
+/* Creates a 1.5 MB file and compares the cost of reaching its
+   last block through a freshly opened file, which must first look
+   up the whole cluster chain, against seeking to the last block
+   of a file that is already open. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (1536 * 1024)
+#define SEEK_CNT 200
+
+static char buf[512];
+
+void
+test_main (void) 
+{
+  const char *file_name = "bench";
+  long long start;
+  int fd;
+  int i;
+
+  CHECK (create (file_name, FILE_SIZE), "create \"%s\"", file_name);
+
+  msg ("reading last block of \"%s\" after each open", file_name);
+  start = get_timer_ticks ();
+  for (i = 0; i < SEEK_CNT; i++)
+    {
+      if ((fd = open (file_name)) < 2)
+        fail ("open %d failed", i);
+      seek (fd, FILE_SIZE - sizeof buf);
+      if (read (fd, buf, sizeof buf) != sizeof buf)
+        fail ("read %d failed", i);
+      close (fd);
+    }
+  msg ("cold seek: %d reads in %lld ticks", SEEK_CNT,
+       get_timer_ticks () - start);
+
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  msg ("reading last block of \"%s\" while open", file_name);
+  start = get_timer_ticks ();
+  for (i = 0; i < SEEK_CNT; i++)
+    {
+      seek (fd, 0);
+      if (read (fd, buf, sizeof buf) != sizeof buf)
+        fail ("read %d at start failed", i);
+      seek (fd, FILE_SIZE - sizeof buf);
+      if (read (fd, buf, sizeof buf) != sizeof buf)
+        fail ("read %d at end failed", i);
+    }
+  msg ("warm seek: %d reads in %lld ticks", SEEK_CNT,
+       get_timer_ticks () - start);
+
+  msg ("close \"%s\"", file_name);
+  close (fd);
+}
@@ -0,0 +1,184 @@
+/* Test program for scanning in lib/kernel/bitmap.c.
+
+   Checks bitmap_scan(), bitmap_scan_and_flip(), bitmap_count() and
+   bitmap_contains() against bit-at-a-time versions on random
+   bitmaps, then reports the cycles bitmap_scan_and_flip() takes
+   per allocation at several fill ratios.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <debug.h>
+#include <random.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Number of bits in the bitmaps checked. */
+#define CHECK_BITS 300
+
+/* Number of bits in the bitmap timed, as in a 128 MB pool. */
+#define BENCH_BITS 32768
+
+/* Allocations timed at each fill ratio. */
+#define BENCH_ALLOCS 1000
+
+static void check_scan (void);
+static void check_count (void);
+static void bench (void);
+
+/* Test bitmap scanning. */
+void
+test (void) 
+{
+  check_scan ();
+  check_count ();
+  bench ();
+  printf ("bitmap: PASS\n");
+}
+
+/* Sets each bit in B to true with probability PERCENT / 100. */
+static void
+fill_random (struct bitmap *b, int percent) 
+{
+  size_t i;
+
+  for (i = 0; i < bitmap_size (b); i++)
+    bitmap_set (b, i, (int) (random_ulong () % 100) < percent);
+}
+
+/* Returns what bitmap_scan (B, START, CNT, VALUE) should return,
+   working a bit at a time. */
+static size_t
+slow_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) 
+{
+  size_t i, j;
+
+  for (i = start; i + cnt <= bitmap_size (b); i++) 
+    {
+      for (j = 0; j < cnt; j++)
+        if (bitmap_test (b, i + j) != value)
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
+
+/* Checks scans for groups of every size from every start, and
+   that repeated allocations come out lowest first. */
+static void
+check_scan (void) 
+{
+  struct bitmap *b = bitmap_create (CHECK_BITS);
+  int percent;
+
+  ASSERT (b != NULL);
+  for (percent = 0; percent <= 100; percent += 10) 
+    {
+      size_t start, cnt;
+
+      fill_random (b, percent);
+      for (start = 0; start <= CHECK_BITS; start += 7)
+        for (cnt = 0; cnt <= 130; cnt++) 
+          {
+            ASSERT (bitmap_scan (b, start, cnt, false)
+                    == slow_scan (b, start, cnt, false));
+            ASSERT (bitmap_scan (b, start, cnt, true)
+                    == slow_scan (b, start, cnt, true));
+          }
+
+      for (;;) 
+        {
+          size_t cnt = random_ulong () % 5 + 1;
+          size_t expect = slow_scan (b, 0, cnt, false);
+          size_t idx = bitmap_scan_and_flip (b, 0, cnt, false);
+
+          ASSERT (idx == expect);
+          if (idx == BITMAP_ERROR)
+            break;
+          ASSERT (bitmap_all (b, idx, cnt));
+
+          /* Free something now and then so the hint must move
+             back down. */
+          if (random_ulong () % 4 == 0) 
+            {
+              size_t victim = random_ulong () % CHECK_BITS;
+              bitmap_reset (b, victim);
+            }
+        }
+    }
+  bitmap_destroy (b);
+}
+
+/* Checks bitmap_count() and bitmap_contains() on ranges that start
+   and end at every offset within an element. */
+static void
+check_count (void) 
+{
+  struct bitmap *b = bitmap_create (CHECK_BITS);
+  size_t start, cnt, i;
+
+  ASSERT (b != NULL);
+  fill_random (b, 50);
+  for (start = 0; start < 140; start++)
+    for (cnt = 0; start + cnt <= CHECK_BITS; cnt += 3) 
+      {
+        size_t ones = 0;
+
+        for (i = 0; i < cnt; i++)
+          ones += bitmap_test (b, start + i);
+        ASSERT (bitmap_count (b, start, cnt, true) == ones);
+        ASSERT (bitmap_count (b, start, cnt, false) == cnt - ones);
+        ASSERT (bitmap_contains (b, start, cnt, true) == (ones > 0));
+        ASSERT (bitmap_contains (b, start, cnt, false) == (ones < cnt));
+      }
+  bitmap_destroy (b);
+}
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc (void) 
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* Reports the average cycles to allocate one bit and a group of 8
+   bits, lowest first, from a bitmap with the given share of its
+   bits already in use. */
+static void
+bench (void) 
+{
+  static const int percents[] = { 0, 50, 90, 99 };
+  struct bitmap *b = bitmap_create (BENCH_BITS);
+  size_t i;
+
+  ASSERT (b != NULL);
+  printf ("cycles per allocation:\n");
+  printf ("%6s %9s %9s\n", "full", "1 bit", "8 bits");
+  for (i = 0; i < sizeof percents / sizeof *percents; i++) 
+    {
+      size_t cnt;
+
+      printf ("%5d%%", percents[i]);
+      for (cnt = 1; cnt <= 8; cnt += 7) 
+        {
+          uint64_t start;
+          int j;
+
+          fill_random (b, percents[i]);
+
+          start = rdtsc ();
+          for (j = 0; j < BENCH_ALLOCS; j++)
+            bitmap_scan_and_flip (b, 0, cnt, false);
+          printf (" %9llu", (rdtsc () - start) / BENCH_ALLOCS);
+        }
+      printf ("\n");
+    }
+  bitmap_destroy (b);
+}
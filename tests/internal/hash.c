@@ -0,0 +1,204 @@
+/* Test program for lib/kernel/hash.c and lib/kernel/ohash.c.
+
+   Runs the same random inserts, finds and deletes against the
+   chained and the open-addressing table and checks both against a
+   plain array, then reports the cycles per insert, find and delete
+   for each table at sizes from 1,000 to 1,000,000 elements.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <hash.h>
+#include <ohash.h>
+#include <random.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/test.h"
+
+/* Number of keys in the correctness check. */
+#define CHECK_KEYS 5000
+
+/* Operations in the correctness check. */
+#define CHECK_OPS 100000
+
+/* Largest table timed. */
+#define MAX_ELEMS 1000000
+
+/* An element, keyed by KEY. */
+struct item 
+  {
+    struct hash_elem elem;
+    uint64_t key;
+  };
+
+static uint64_t
+item_hash (const struct hash_elem *e, void *aux UNUSED) 
+{
+  return hash_bytes (&hash_entry (e, struct item, elem)->key,
+                     sizeof (uint64_t));
+}
+
+static bool
+item_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux UNUSED) 
+{
+  return (hash_entry (a, struct item, elem)->key
+          < hash_entry (b, struct item, elem)->key);
+}
+
+static void check (void);
+static void bench (void);
+
+/* Test the hash tables. */
+void
+test (void) 
+{
+  check ();
+  bench ();
+  printf ("hash: PASS\n");
+}
+
+/* Checks both tables against an array of flags. */
+static void
+check (void) 
+{
+  static struct item chained[CHECK_KEYS], open[CHECK_KEYS];
+  static bool present[CHECK_KEYS];
+  struct hash h;
+  struct ohash o;
+  struct hash_iterator hi;
+  struct ohash_iterator oi;
+  size_t cnt;
+  int i;
+
+  ASSERT (hash_init (&h, item_hash, item_less, NULL));
+  ASSERT (ohash_init (&o, item_hash, item_less, NULL));
+  for (i = 0; i < CHECK_KEYS; i++)
+    chained[i].key = open[i].key = i;
+
+  for (i = 0; i < CHECK_OPS; i++) 
+    {
+      int k = random_ulong () % CHECK_KEYS;
+      struct item key;
+
+      key.key = k;
+      switch (random_ulong () % 3) 
+        {
+        case 0:
+          ASSERT ((hash_insert (&h, &chained[k].elem) != NULL) == present[k]);
+          ASSERT ((ohash_insert (&o, &open[k].elem) != NULL) == present[k]);
+          present[k] = true;
+          break;
+        case 1:
+          ASSERT ((hash_find (&h, &key.elem) != NULL) == present[k]);
+          ASSERT ((ohash_find (&o, &key.elem) != NULL) == present[k]);
+          break;
+        case 2:
+          ASSERT ((hash_delete (&h, &key.elem) != NULL) == present[k]);
+          ASSERT ((ohash_delete (&o, &key.elem) != NULL) == present[k]);
+          present[k] = false;
+          break;
+        }
+    }
+
+  cnt = 0;
+  for (i = 0; i < CHECK_KEYS; i++)
+    cnt += present[i];
+  ASSERT (hash_size (&h) == cnt && ohash_size (&o) == cnt);
+
+  /* Each table iterates over each present element once. */
+  hash_first (&hi, &h);
+  while (hash_next (&hi)) 
+    {
+      struct item *p = hash_entry (hash_cur (&hi), struct item, elem);
+      ASSERT (present[p->key]);
+      cnt--;
+    }
+  ASSERT (cnt == 0);
+  ohash_first (&oi, &o);
+  while (ohash_next (&oi)) 
+    {
+      struct item *p = hash_entry (ohash_cur (&oi), struct item, elem);
+      ASSERT (present[p->key]);
+      cnt++;
+    }
+  ASSERT (cnt == ohash_size (&o));
+
+  hash_destroy (&h, NULL);
+  ohash_destroy (&o, NULL);
+}
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc (void) 
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* Reports cycles per insert, find and delete of CNT elements with
+   random keys in each table. */
+static void
+bench (void) 
+{
+  size_t cnt;
+
+  printf ("cycles per operation:\n");
+  printf ("%8s %8s %8s %8s %8s %8s %8s\n", "elems", "insert", "find",
+          "delete", "oinsert", "ofind", "odelete");
+  for (cnt = 1000; cnt <= MAX_ELEMS; cnt *= 10) 
+    {
+      struct item *items = malloc (cnt * sizeof *items);
+      struct hash h;
+      struct ohash o;
+      uint64_t start;
+      size_t i;
+
+      if (items == NULL || !hash_init (&h, item_hash, item_less, NULL)) 
+        {
+          printf ("%8zu out of memory\n", cnt);
+          free (items);
+          break;
+        }
+      ASSERT (ohash_init (&o, item_hash, item_less, NULL));
+      for (i = 0; i < cnt; i++)
+        items[i].key = random_ulong ();
+      printf ("%8zu", cnt);
+
+      start = rdtsc ();
+      for (i = 0; i < cnt; i++)
+        hash_insert (&h, &items[i].elem);
+      printf (" %8llu", (rdtsc () - start) / cnt);
+      start = rdtsc ();
+      for (i = 0; i < cnt; i++)
+        ASSERT (hash_find (&h, &items[i].elem) != NULL);
+      printf (" %8llu", (rdtsc () - start) / cnt);
+      start = rdtsc ();
+      for (i = 0; i < cnt; i++)
+        hash_delete (&h, &items[i].elem);
+      printf (" %8llu", (rdtsc () - start) / cnt);
+
+      start = rdtsc ();
+      for (i = 0; i < cnt; i++)
+        ohash_insert (&o, &items[i].elem);
+      printf (" %8llu", (rdtsc () - start) / cnt);
+      start = rdtsc ();
+      for (i = 0; i < cnt; i++)
+        ASSERT (ohash_find (&o, &items[i].elem) != NULL);
+      printf (" %8llu", (rdtsc () - start) / cnt);
+      start = rdtsc ();
+      for (i = 0; i < cnt; i++)
+        ohash_delete (&o, &items[i].elem);
+      printf (" %8llu\n", (rdtsc () - start) / cnt);
+
+      hash_destroy (&h, NULL);
+      ohash_destroy (&o, NULL);
+      free (items);
+    }
+}
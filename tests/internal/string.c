@@ -0,0 +1,207 @@
+/* Test program for the block functions in lib/string.c.
+
+   Checks memcpy(), memmove(), memset() and memcmp() against
+   byte-at-a-time versions for every alignment of small blocks,
+   then reports how many bytes per cycle each moves for block
+   sizes from 8 bytes to 64 kB.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <random.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/test.h"
+
+/* Largest block size checked for correctness. */
+#define CHECK_SIZE 300
+
+/* Largest block size timed. */
+#define MAX_SIZE (64 * 1024)
+
+/* Bytes moved by each timing run. */
+#define BENCH_BYTES (4 * 1024 * 1024)
+
+static uint8_t src[MAX_SIZE + 16];
+static uint8_t dst[MAX_SIZE + 16];
+static uint8_t ref[MAX_SIZE + 16];
+
+static void check_copy (void);
+static void check_move (void);
+static void check_set (void);
+static void check_cmp (void);
+static void bench (void);
+
+/* Test the block functions. */
+void
+test (void) 
+{
+  check_copy ();
+  check_move ();
+  check_set ();
+  check_cmp ();
+  bench ();
+  printf ("string: PASS\n");
+}
+
+/* Fills BUF with SIZE random bytes. */
+static void
+fill_random (uint8_t *buf, size_t size) 
+{
+  random_bytes (buf, size);
+}
+
+/* Checks memcpy() for each size up to CHECK_SIZE and each
+   alignment of source and destination. */
+static void
+check_copy (void) 
+{
+  size_t size, s_ofs, d_ofs, i;
+
+  for (size = 0; size <= CHECK_SIZE; size++)
+    for (s_ofs = 0; s_ofs < 8; s_ofs++)
+      for (d_ofs = 0; d_ofs < 8; d_ofs++) 
+        {
+          fill_random (src, sizeof src);
+          fill_random (dst, sizeof dst);
+          memcpy (ref, dst, sizeof ref);
+          for (i = 0; i < size; i++)
+            ref[d_ofs + i] = src[s_ofs + i];
+
+          ASSERT (memcpy (dst + d_ofs, src + s_ofs, size) == dst + d_ofs);
+          for (i = 0; i < sizeof dst; i++)
+            ASSERT (dst[i] == ref[i]);
+        }
+}
+
+/* Checks memmove() with overlapping blocks in both directions. */
+static void
+check_move (void) 
+{
+  size_t size, a, b, i;
+
+  for (size = 0; size <= CHECK_SIZE; size += 7)
+    for (a = 0; a < 16; a++)
+      for (b = 0; b < 16; b++) 
+        {
+          fill_random (dst, sizeof dst);
+          memcpy (ref, dst, sizeof ref);
+          memcpy (src, dst, sizeof src);
+          for (i = 0; i < size; i++)
+            ref[b + i] = src[a + i];
+
+          ASSERT (memmove (dst + b, dst + a, size) == dst + b);
+          for (i = 0; i < sizeof dst; i++)
+            ASSERT (dst[i] == ref[i]);
+        }
+}
+
+/* Checks memset() for each size up to CHECK_SIZE and each
+   alignment of the destination. */
+static void
+check_set (void) 
+{
+  size_t size, ofs, i;
+
+  for (size = 0; size <= CHECK_SIZE; size++)
+    for (ofs = 0; ofs < 8; ofs++) 
+      {
+        int value = random_ulong () & 0xff;
+
+        fill_random (dst, sizeof dst);
+        memcpy (ref, dst, sizeof ref);
+        for (i = 0; i < size; i++)
+          ref[ofs + i] = value;
+
+        ASSERT (memset (dst + ofs, value, size) == dst + ofs);
+        for (i = 0; i < sizeof dst; i++)
+          ASSERT (dst[i] == ref[i]);
+      }
+}
+
+/* Checks that memcmp() finds a single differing byte anywhere in
+   a block, in either direction. */
+static void
+check_cmp (void) 
+{
+  size_t size, pos;
+
+  for (size = 1; size <= CHECK_SIZE; size += 3)
+    for (pos = 0; pos < size; pos++) 
+      {
+        fill_random (src, size);
+        memcpy (dst, src, size);
+        ASSERT (memcmp (src, dst, size) == 0);
+
+        src[pos] = 0x10;
+        dst[pos] = 0x80;
+        ASSERT (memcmp (src, dst, size) < 0);
+        ASSERT (memcmp (dst, src, size) > 0);
+        ASSERT (memcmp (src, dst, pos) == 0);
+      }
+}
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc (void) 
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* Prints BYTES / CYCLES to two decimal places. */
+static void
+print_rate (uint64_t bytes, uint64_t cycles) 
+{
+  uint64_t hundredths = cycles > 0 ? bytes * 100 / cycles : 0;
+  printf (" %6llu.%02llu", hundredths / 100, hundredths % 100);
+}
+
+/* Reports bytes per cycle for memcpy(), memmove(), memset() and
+   memcmp() on blocks of 8 bytes to MAX_SIZE bytes. */
+static void
+bench (void) 
+{
+  size_t size;
+
+  printf ("bytes per cycle:\n");
+  printf ("%8s %9s %9s %9s %9s\n", "size", "memcpy", "memmove", "memset",
+          "memcmp");
+  memset (src, 0x5a, sizeof src);
+  for (size = 8; size <= MAX_SIZE; size *= 2) 
+    {
+      size_t reps = BENCH_BYTES / size;
+      uint64_t start;
+      size_t i;
+
+      printf ("%8zu", size);
+
+      start = rdtsc ();
+      for (i = 0; i < reps; i++)
+        memcpy (dst, src, size);
+      print_rate (reps * size, rdtsc () - start);
+
+      start = rdtsc ();
+      for (i = 0; i < reps; i++)
+        memmove (dst + 8, dst, size);
+      print_rate (reps * size, rdtsc () - start);
+
+      start = rdtsc ();
+      for (i = 0; i < reps; i++)
+        memset (dst, i, size);
+      print_rate (reps * size, rdtsc () - start);
+
+      memcpy (dst, src, size);
+      start = rdtsc ();
+      for (i = 0; i < reps; i++)
+        ASSERT (memcmp (dst, src, size) == 0);
+      print_rate (reps * size, rdtsc () - start);
+
+      printf ("\n");
+    }
+}
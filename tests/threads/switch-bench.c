@@ -0,0 +1,55 @@
+/* Measures voluntary context switches.  The main thread and a
+   partner of equal priority bounce control back and forth through
+   a pair of semaphores, so every iteration is two switches, and
+   the test reports how many switches it managed per second. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ITERATIONS 100000
+
+static thread_func pong_thread;
+static struct semaphore ping, pong, done;
+
+void
+test_switch_bench (void) 
+{
+  int64_t start, ticks;
+  int i;
+
+  sema_init (&ping, 0);
+  sema_init (&pong, 0);
+  sema_init (&done, 0);
+  thread_create ("pong", thread_get_priority (), pong_thread, NULL);
+
+  start = timer_ticks ();
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      sema_up (&ping);
+      sema_down (&pong);
+    }
+  ticks = timer_elapsed (start);
+  sema_down (&done);
+
+  msg ("%d switches in %lld ticks", 2 * ITERATIONS, ticks);
+  if (ticks > 0)
+    msg ("%lld switches per second",
+         2LL * ITERATIONS * TIMER_FREQ / ticks);
+}
+
+static void
+pong_thread (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      sema_down (&ping);
+      sema_up (&pong);
+    }
+  sema_up (&done);
+}
@@ -0,0 +1,24 @@
+/* Child process run by exec-bench.
+   Writes a byte to the file descriptor passed as its second
+   command-line argument to say that it is running, then reads the
+   one passed as its first until end of file. */
+
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-wait";
+
+int
+main (int argc, char *argv[]) 
+{
+  char c = 'r';
+
+  if (argc != 3)
+    fail ("bad command-line arguments");
+  if (write (atoi (argv[2]), &c, 1) != 1)
+    fail ("write failed");
+  while (read (atoi (argv[1]), &c, 1) > 0)
+    continue;
+  return 0;
+}
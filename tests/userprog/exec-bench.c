@@ -0,0 +1,56 @@
+/* Starts 32 copies of one executable side by side and reports how
+   long it took and how many user frames each copy costs.  Copies
+   share the frames of their read-only text, so the count should
+   come out well below the size of the program. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 32
+
+void
+test_main (void) 
+{
+  pid_t pids[CHILD_CNT];
+  int hold[2], ready[2];
+  long long start, frames;
+  char c;
+  int i;
+
+  CHECK (pipe (hold) == 0 && pipe (ready) == 0, "create pipes");
+
+  frames = get_user_frame_cnt ();
+  start = get_timer_ticks ();
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      pids[i] = fork ("child");
+      if (pids[i] == 0)
+        {
+          char cmd[32];
+
+          /* Only the parent may hold the write end, or the copies
+             would never see end of file. */
+          close (hold[1]);
+          close (ready[0]);
+          snprintf (cmd, sizeof cmd, "child-wait %d %d", hold[0], ready[1]);
+          exec (cmd);
+          fail ("exec failed");
+        }
+      if (pids[i] < 0)
+        fail ("fork failed");
+    }
+  for (i = 0; i < CHILD_CNT; i++)
+    if (read (ready[0], &c, 1) != 1)
+      fail ("child %d did not start", i);
+  msg ("%d copies started in %lld ticks", CHILD_CNT,
+       get_timer_ticks () - start);
+  msg ("%lld user frames per copy",
+       (get_user_frame_cnt () - frames) / CHILD_CNT);
+
+  close (hold[1]);
+  for (i = 0; i < CHILD_CNT; i++)
+    if (wait (pids[i]) != 0)
+      fail ("child %d failed", i);
+}
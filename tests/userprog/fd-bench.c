@@ -0,0 +1,44 @@
+/* Holds 3, 128 and then 4,096 descriptors open (counting the
+   console) and, at each level, times closing and reopening one
+   descriptor.  The lowest free descriptor is found through a
+   bitmap, so the cost should not grow with the number held. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FD_CNT 4096
+#define OPEN_CNT 10000
+
+static int fds[FD_CNT];
+
+void
+test_main (void) 
+{
+  static const int levels[] = {3, 128, FD_CNT};
+  int held = 2;
+  size_t l;
+  int i;
+
+  for (l = 0; l < sizeof levels / sizeof *levels; l++)
+    {
+      long long start;
+
+      for (; held < levels[l]; held++)
+        if ((fds[held] = open ("sample.txt")) != held)
+          fail ("open returned %d, expected %d", fds[held], held);
+
+      start = get_timer_ticks ();
+      for (i = 0; i < OPEN_CNT; i++)
+        {
+          close (2);
+          if (open ("sample.txt") != 2)
+            fail ("reopen %d did not return lowest descriptor", i);
+        }
+      msg ("%d descriptors: %d close/open pairs in %lld ticks", held,
+           OPEN_CNT, get_timer_ticks () - start);
+    }
+
+  if (open ("sample.txt") != -1)
+    fail ("open beyond %d descriptors succeeded", FD_CNT);
+}
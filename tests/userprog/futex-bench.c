@@ -0,0 +1,44 @@
+/* Measures the cost of futex-based mutexes.  An uncontended
+   mutex_lock/mutex_unlock pair stays in user space, and is timed
+   against a futex_wake() system call, which is what every unlock
+   would cost if the lock lived in the kernel.  Also checks that
+   futex_wait() returns at once when the word has changed. */
+
+#include <futex.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ITERATIONS 100000
+
+static struct mutex mutex = MUTEX_INITIALIZER;
+static int word;
+
+void
+test_main (void) 
+{
+  long long start;
+  int i;
+
+  CHECK (futex_wait (&word, 1) == -1, "futex_wait on changed word");
+  CHECK (futex_wake (&word, 1) == 0, "futex_wake with no waiters");
+
+  start = get_timer_ticks ();
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      mutex_lock (&mutex);
+      mutex_unlock (&mutex);
+    }
+  msg ("mutex lock/unlock: %d pairs in %lld ticks", ITERATIONS,
+       get_timer_ticks () - start);
+
+  start = get_timer_ticks ();
+  for (i = 0; i < ITERATIONS; i++)
+    futex_wake (&word, 1);
+  msg ("futex_wake: %d calls in %lld ticks", ITERATIONS,
+       get_timer_ticks () - start);
+
+  CHECK (mutex_trylock (&mutex), "mutex_trylock on free mutex");
+  CHECK (!mutex_trylock (&mutex), "mutex_trylock on held mutex");
+  mutex_unlock (&mutex);
+}
@@ -0,0 +1,109 @@
+/* Exercises the user heap allocator and reports timer ticks for
+   three workloads: allocating and freeing one small block over and
+   over, keeping a pool of live blocks of mixed sizes, and the
+   first workload run by several threads at once.  Every block is
+   filled and checked, so overlapping blocks are caught. */
+
+#include <malloc.h>
+#include <random.h>
+#include <stdint.h>
+#include <syscall.h>
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ITERATIONS 100000
+#define POOL_SIZE 1000
+#define MAX_SIZE 8192
+#define THREAD_CNT 4
+
+static char *pool[POOL_SIZE];
+static size_t pool_size[POOL_SIZE];
+
+/* Fills SIZE bytes at P with a byte derived from P. */
+static void
+fill (char *p, size_t size) 
+{
+  memset (p, (uintptr_t) p >> 4, size);
+}
+
+/* Checks that P still holds what fill() put there. */
+static void
+check (const char *p, size_t size) 
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    if (p[i] != (char) ((uintptr_t) p >> 4))
+      fail ("block %p corrupted at byte %zu", p, i);
+}
+
+/* Allocates and frees a 32-byte block ITERATIONS times. */
+static void
+churn (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      char *p = malloc (32);
+      if (p == NULL)
+        fail ("malloc failed");
+      p[0] = p[31] = 'x';
+      free (p);
+    }
+}
+
+void
+test_main (void) 
+{
+  tid_t tids[THREAD_CNT];
+  long long start;
+  void *brk;
+  int i;
+
+  brk = sbrk (0);
+  CHECK (brk != (void *) -1, "sbrk (0)");
+  CHECK (sbrk (-1) == (void *) -1, "sbrk below heap start fails");
+
+  start = get_timer_ticks ();
+  churn (NULL);
+  msg ("malloc/free: %d pairs in %lld ticks", ITERATIONS,
+       get_timer_ticks () - start);
+
+  random_init (0);
+  start = get_timer_ticks ();
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      int slot = random_ulong () % POOL_SIZE;
+
+      if (pool[slot] != NULL)
+        {
+          check (pool[slot], pool_size[slot]);
+          free (pool[slot]);
+        }
+      pool_size[slot] = random_ulong () % MAX_SIZE + 1;
+      pool[slot] = malloc (pool_size[slot]);
+      if (pool[slot] == NULL)
+        fail ("malloc (%zu) failed", pool_size[slot]);
+      fill (pool[slot], pool_size[slot]);
+    }
+  for (i = 0; i < POOL_SIZE; i++)
+    if (pool[i] != NULL)
+      {
+        check (pool[i], pool_size[i]);
+        free (pool[i]);
+      }
+  msg ("mixed sizes: %d allocations in %lld ticks", ITERATIONS,
+       get_timer_ticks () - start);
+
+  start = get_timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++)
+    if ((tids[i] = thread_create (churn, NULL)) == TID_ERROR)
+      fail ("thread_create failed");
+  for (i = 0; i < THREAD_CNT; i++)
+    if (thread_join (tids[i]) != 0)
+      fail ("thread %d failed", i);
+  msg ("%d threads: %d pairs in %lld ticks", THREAD_CNT,
+       THREAD_CNT * ITERATIONS, get_timer_ticks () - start);
+}
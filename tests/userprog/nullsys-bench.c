@@ -0,0 +1,37 @@
+/* Measures the round trip through the system call entry and exit
+   code.  tell() on a descriptor that is not open returns at once,
+   so nearly all of its cost is getting into and out of the
+   kernel. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CALL_CNT 100000
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc (void) 
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+void
+test_main (void) 
+{
+  uint64_t start, cycles;
+  long long ticks;
+  int i;
+
+  ticks = get_timer_ticks ();
+  start = rdtsc ();
+  for (i = 0; i < CALL_CNT; i++)
+    if (tell (-1) != (unsigned) -1)
+      fail ("tell %d did not fail", i);
+  cycles = rdtsc () - start;
+  msg ("%d calls in %lld ticks, %llu cycles per call", CALL_CNT,
+       get_timer_ticks () - ticks, cycles / CALL_CNT);
+}
@@ -0,0 +1,136 @@
+/* Measures throughput between two processes over a pipe: a child
+   writes 1 MB into the pipe and the parent drains it.  This is done
+   once from memory to memory, and twice from a file to a file,
+   first with read and write and then with splice, which moves the
+   bytes between the file and the pipe's buffer directly.  Reports
+   bytes per timer tick for each. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define DATA_SIZE (1024 * 1024)
+#define CHUNK 4096
+
+static char buf[CHUNK];
+
+/* Ways to move the bytes. */
+enum mode
+  {
+    MEMORY,             /* From a buffer to a buffer. */
+    READ_WRITE,         /* From a file to a file with read and write. */
+    SPLICE              /* From a file to a file with splice. */
+  };
+
+/* Moves everything that arrives on pipe end RD to OUT, either with
+   splice or through BUF.  Returns the number of bytes moved. */
+static int
+drain (int rd, int out, enum mode mode) 
+{
+  int total = 0;
+  int n;
+
+  for (;;)
+    {
+      if (mode == SPLICE)
+        n = splice (rd, out, CHUNK);
+      else
+        {
+          n = read (rd, buf, CHUNK);
+          if (n > 0 && mode == READ_WRITE && write (out, buf, n) != n)
+            fail ("write to \"copy\" failed");
+        }
+      if (n < 0)
+        fail ("draining the pipe failed");
+      if (n == 0)
+        return total;
+      total += n;
+    }
+}
+
+/* Child side: writes DATA_SIZE bytes to pipe end WR, from memory or
+   from file IN, then exits. */
+static void
+fill (int in, int wr, enum mode mode) 
+{
+  int total = 0;
+  int n;
+
+  while (total < DATA_SIZE)
+    {
+      if (mode == SPLICE)
+        n = splice (in, wr, DATA_SIZE - total);
+      else
+        {
+          if (mode == READ_WRITE && read (in, buf, CHUNK) != CHUNK)
+            exit (1);
+          n = write (wr, buf, CHUNK);
+        }
+      if (n <= 0)
+        exit (1);
+      total += n;
+    }
+  exit (0);
+}
+
+/* Runs one transfer in MODE and reports its rate. */
+static void
+run (const char *how, enum mode mode) 
+{
+  int fds[2];
+  int in = -1, out = -1;
+  long long start, ticks;
+  pid_t pid;
+  int total;
+
+  if (mode != MEMORY)
+    {
+      CHECK ((in = open ("data")) > 1, "open \"data\"");
+      remove ("copy");
+      CHECK (create ("copy", 0), "create \"copy\"");
+      CHECK ((out = open ("copy")) > 1, "open \"copy\"");
+    }
+  CHECK (pipe (fds) == 0, "pipe");
+
+  start = get_timer_ticks ();
+  if ((pid = fork ("child")) == 0)
+    {
+      close (fds[0]);
+      fill (in, fds[1], mode);
+    }
+  close (fds[1]);
+  total = drain (fds[0], out, mode);
+  ticks = get_timer_ticks () - start;
+  if (wait (pid) != 0)
+    fail ("child failed");
+  if (total != DATA_SIZE)
+    fail ("moved %d bytes instead of %d", total, DATA_SIZE);
+  msg ("%s: %d bytes in %lld ticks (%lld bytes/tick)", how, total, ticks,
+       total / (ticks > 0 ? ticks : 1));
+
+  close (fds[0]);
+  if (mode != MEMORY)
+    {
+      close (in);
+      close (out);
+    }
+}
+
+void
+test_main (void) 
+{
+  int fd, i;
+
+  CHECK (create ("data", DATA_SIZE), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  for (i = 0; i < CHUNK; i++)
+    buf[i] = i;
+  for (i = 0; i < DATA_SIZE / CHUNK; i++)
+    if (write (fd, buf, CHUNK) != CHUNK)
+      fail ("write to \"data\" failed");
+  close (fd);
+
+  run ("memory", MEMORY);
+  run ("read/write", READ_WRITE);
+  run ("splice", SPLICE);
+}
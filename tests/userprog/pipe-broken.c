@@ -0,0 +1,33 @@
+/* Writes to a pipe whose only reader, a child, exits without
+   reading.  A write blocked on the full pipe must wake up and
+   return short, and later writes must fail.  Also checks that the
+   write end cannot be read. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[8192];
+
+void
+test_main (void) 
+{
+  int fds[2];
+  pid_t pid;
+  int n;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  if ((pid = fork ("child")) == 0)
+    exit (0);
+  close (fds[0]);
+
+  /* Blocks once the pipe fills, until the child exits. */
+  n = write (fds[1], buf, sizeof buf);
+  CHECK (n < (int) sizeof buf, "write with reader gone");
+  n = write (fds[1], buf, 1);
+  CHECK (n == -1, "write to broken pipe");
+  n = read (fds[1], buf, 1);
+  CHECK (n == -1, "read from write end");
+  close (fds[1]);
+  wait (pid);
+}
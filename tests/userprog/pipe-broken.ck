@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-broken) begin
+(pipe-broken) pipe
+child: exit(0)
+(pipe-broken) write with reader gone
+(pipe-broken) write to broken pipe
+(pipe-broken) read from write end
+(pipe-broken) end
+pipe-broken: exit(0)
+EOF
+pass;
@@ -0,0 +1,33 @@
+/* A child writes to a pipe and exits.  The parent reads what it
+   wrote and then sees end of file, because no write end is left
+   open. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int fds[2];
+  char buf[16];
+  pid_t pid;
+  int n;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  if ((pid = fork ("child")) == 0)
+    {
+      close (fds[0]);
+      exit (write (fds[1], "hello", 5) == 5 ? 0 : 1);
+    }
+  close (fds[1]);
+  n = wait (pid);
+  CHECK (n == 0, "wait for child");
+
+  n = read (fds[0], buf, sizeof buf);
+  CHECK (n == 5 && !memcmp (buf, "hello", 5), "read \"hello\"");
+  n = read (fds[0], buf, sizeof buf);
+  CHECK (n == 0, "read at end of file");
+  close (fds[0]);
+}
@@ -0,0 +1,109 @@
+/* Reads an array of integers from a file and sorts it, first in
+   one thread and then split among several threads that each read
+   and sort a part, after which the parts are merged.  Reports the
+   timer ticks taken each way.  With one CPU the threads cannot sort
+   in parallel, but one thread's sorting can overlap another's
+   reading. */
+
+#include <random.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ELEM_CNT 65536
+#define THREAD_CNT 4
+#define PART_CNT (ELEM_CNT / THREAD_CNT)
+
+static int data[ELEM_CNT];
+static int merged[ELEM_CNT];
+static int fd;
+
+static int
+compare_ints (const void *a_, const void *b_) 
+{
+  const int *a = a_, *b = b_;
+  return *a < *b ? -1 : *a > *b;
+}
+
+/* Checks that ARRAY is in ascending order. */
+static void
+verify (const int *array, const char *how) 
+{
+  int i;
+
+  for (i = 1; i < ELEM_CNT; i++)
+    if (array[i - 1] > array[i])
+      fail ("%s: element %d out of order", how, i);
+}
+
+/* Reads and sorts part number (int) AUX of the file. */
+static void
+sort_part (void *aux) 
+{
+  int part = (uintptr_t) aux;
+  int *base = data + part * PART_CNT;
+  int size = PART_CNT * sizeof *data;
+
+  if (pread (fd, base, size, part * size) != size)
+    thread_exit (1);
+  qsort (base, PART_CNT, sizeof *data, compare_ints);
+}
+
+/* Merges the sorted parts of DATA into MERGED. */
+static void
+merge_parts (void) 
+{
+  int pos[THREAD_CNT];
+  int i, j;
+
+  for (j = 0; j < THREAD_CNT; j++)
+    pos[j] = 0;
+  for (i = 0; i < ELEM_CNT; i++)
+    {
+      int best = -1;
+      for (j = 0; j < THREAD_CNT; j++)
+        if (pos[j] < PART_CNT
+            && (best < 0 || data[j * PART_CNT + pos[j]]
+                            < data[best * PART_CNT + pos[best]]))
+          best = j;
+      merged[i] = data[best * PART_CNT + pos[best]++];
+    }
+}
+
+void
+test_main (void) 
+{
+  tid_t tids[THREAD_CNT];
+  long long start;
+  int i;
+
+  random_init (0);
+  for (i = 0; i < ELEM_CNT; i++)
+    data[i] = random_ulong () % 1000000;
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  if (write (fd, data, sizeof data) != sizeof data)
+    fail ("write \"data\" failed");
+
+  start = get_timer_ticks ();
+  if (pread (fd, data, sizeof data, 0) != sizeof data)
+    fail ("read \"data\" failed");
+  qsort (data, ELEM_CNT, sizeof *data, compare_ints);
+  msg ("1 thread: %lld ticks", get_timer_ticks () - start);
+  verify (data, "1 thread");
+
+  start = get_timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++)
+    if ((tids[i] = thread_create (sort_part, (void *) (uintptr_t) i)) == TID_ERROR)
+      fail ("thread_create failed");
+  for (i = 0; i < THREAD_CNT; i++)
+    if (thread_join (tids[i]) != 0)
+      fail ("thread %d failed", i);
+  merge_parts ();
+  msg ("%d threads: %lld ticks", THREAD_CNT, get_timer_ticks () - start);
+  verify (merged, "threads");
+
+  close (fd);
+}
@@ -0,0 +1,35 @@
+/* Reads a file over a page of this program's code while a forked
+   child, which shares that page, is running too.  The kernel must
+   not write through the read-only mapping: the reader is killed
+   and the other process still sees the original code. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int __attribute__ ((noinline))
+victim (int x)
+{
+  return x * 3 + 1;
+}
+
+void
+test_main (void) 
+{
+  char saved[64];
+  int handle;
+  pid_t pid;
+
+  memcpy (saved, (const void *) victim, sizeof saved);
+  if ((pid = fork ("child")) == 0)
+    {
+      CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+      read (handle, (void *) victim, sizeof saved);
+      fail ("should not have survived read()");
+    }
+  CHECK (wait (pid) == -1, "wait for child");
+  CHECK (!memcmp (saved, (const void *) victim, sizeof saved),
+         "code unchanged");
+  CHECK (victim (4) == 13, "code still runs");
+}
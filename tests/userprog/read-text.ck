@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(read-text) begin
+(read-text) open "sample.txt"
+child: exit(-1)
+(read-text) wait for child
+(read-text) code unchanged
+(read-text) code still runs
+(read-text) end
+read-text: exit(0)
+EOF
+pass;
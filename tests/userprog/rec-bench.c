@@ -0,0 +1,109 @@
+/* A record-oriented workload: a file of fixed-size records, each
+   a header followed by a payload, is written and then read back in
+   a scattered order.  The workload is run once with seek plus
+   read/write and once with pread/pwrite and readv/writev, and the
+   system calls made and timer ticks taken are reported for each. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define REC_CNT 512
+#define HDR_SIZE 16
+#define BODY_SIZE 112
+#define REC_SIZE (HDR_SIZE + BODY_SIZE)
+
+static char hdr[HDR_SIZE];
+static char body[BODY_SIZE];
+static char rec[REC_SIZE];
+
+/* Returns the offset of the I'th record visited. */
+static unsigned
+rec_ofs (int i) 
+{
+  return (i * 97 % REC_CNT) * REC_SIZE;
+}
+
+/* Checks that REC holds record number I. */
+static void
+check_rec (const char *r, int i) 
+{
+  if (r[0] != (char) i || r[HDR_SIZE] != (char) ~i)
+    fail ("record %d has wrong contents", i);
+}
+
+void
+test_main (void) 
+{
+  struct iovec iov[2] = {{hdr, HDR_SIZE}, {body, BODY_SIZE}};
+  long long start;
+  int calls;
+  int fd;
+  int i;
+
+  CHECK (create ("records", REC_CNT * REC_SIZE), "create \"records\"");
+  CHECK ((fd = open ("records")) > 1, "open \"records\"");
+
+  /* Seek plus one call per buffer. */
+  calls = 0;
+  start = get_timer_ticks ();
+  for (i = 0; i < REC_CNT; i++)
+    {
+      memset (hdr, i, HDR_SIZE);
+      memset (body, ~i, BODY_SIZE);
+      seek (fd, rec_ofs (i));
+      if (write (fd, hdr, HDR_SIZE) != HDR_SIZE
+          || write (fd, body, BODY_SIZE) != BODY_SIZE)
+        fail ("write record %d failed", i);
+      calls += 3;
+    }
+  for (i = 0; i < REC_CNT; i++)
+    {
+      seek (fd, rec_ofs (i));
+      if (read (fd, rec, REC_SIZE) != REC_SIZE)
+        fail ("read record %d failed", i);
+      check_rec (rec, i);
+      calls += 2;
+    }
+  msg ("seek+read/write: %d calls in %lld ticks", calls,
+       get_timer_ticks () - start);
+
+  /* One call per record. */
+  calls = 0;
+  start = get_timer_ticks ();
+  for (i = 0; i < REC_CNT; i++)
+    {
+      memset (hdr, i, HDR_SIZE);
+      memset (body, ~i, BODY_SIZE);
+      seek (fd, rec_ofs (i));
+      if (writev (fd, iov, 2) != REC_SIZE)
+        fail ("writev record %d failed", i);
+      calls += 2;
+    }
+  for (i = 0; i < REC_CNT; i++)
+    {
+      if (pread (fd, rec, REC_SIZE, rec_ofs (i)) != REC_SIZE)
+        fail ("pread record %d failed", i);
+      check_rec (rec, i);
+      calls++;
+    }
+  for (i = 0; i < REC_CNT; i++)
+    {
+      seek (fd, rec_ofs (i));
+      if (readv (fd, iov, 2) != REC_SIZE)
+        fail ("readv record %d failed", i);
+      if (hdr[0] != (char) i || body[0] != (char) ~i)
+        fail ("record %d has wrong contents", i);
+      calls += 2;
+    }
+  msg ("pread/readv/writev: %d calls in %lld ticks", calls,
+       get_timer_ticks () - start);
+
+  if (pwrite (fd, rec, REC_SIZE, 0) != REC_SIZE)
+    fail ("pwrite failed");
+  if (tell (fd) != rec_ofs (REC_CNT - 1) + REC_SIZE)
+    fail ("pwrite moved the file position");
+
+  close (fd);
+}
@@ -0,0 +1,86 @@
+/* Writes 512-byte blocks to a 64 kB file 100,000 times, once with
+   a write system call per block and once through a submission ring
+   in batches, and reports the timer ticks taken for each. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define WRITE_CNT 100000
+#define BLOCK_SIZE 512
+#define BLOCK_CNT 128
+
+static char block[BLOCK_SIZE];
+
+/* Reports the ticks taken since START to do WRITE_CNT writes. */
+static void
+report (const char *how, long long start) 
+{
+  msg ("%s: %d writes in %lld ticks", how, WRITE_CNT,
+       get_timer_ticks () - start);
+}
+
+/* Reaps every completion in RING, checking that each write
+   succeeded.  Returns the number reaped. */
+static int
+reap (struct ring *ring) 
+{
+  struct ring_cqe *cqe;
+  int cnt = 0;
+
+  while ((cqe = ring_peek_cqe (ring)) != NULL)
+    {
+      if (cqe->res != BLOCK_SIZE)
+        fail ("write %lld returned %d", (long long) cqe->user_data, cqe->res);
+      ring_cqe_seen (ring);
+      cnt++;
+    }
+  return cnt;
+}
+
+void
+test_main (void) 
+{
+  struct ring *ring;
+  long long start;
+  int fd, i, done;
+
+  memset (block, 'r', BLOCK_SIZE);
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+
+  start = get_timer_ticks ();
+  for (i = 0; i < WRITE_CNT; i++)
+    {
+      if (i % BLOCK_CNT == 0)
+        seek (fd, 0);
+      if (write (fd, block, BLOCK_SIZE) != BLOCK_SIZE)
+        fail ("write %d failed", i);
+    }
+  report ("write", start);
+
+  CHECK ((ring = ring_setup (RING_MAX_ENTRIES)) != NULL, "ring_setup");
+  start = get_timer_ticks ();
+  for (i = done = 0; i < WRITE_CNT; )
+    {
+      struct ring_sqe *sqe;
+
+      while (i < WRITE_CNT && (sqe = ring_get_sqe (ring)) != NULL)
+        {
+          sqe->opcode = RING_OP_WRITE;
+          sqe->fd = fd;
+          sqe->addr = (uint64_t) block;
+          sqe->len = BLOCK_SIZE;
+          sqe->off = i % BLOCK_CNT * BLOCK_SIZE;
+          sqe->user_data = i++;
+        }
+      if (ring_submit (ring) <= 0)
+        fail ("ring_submit failed");
+      done += reap (ring);
+    }
+  report ("ring", start);
+  if (done != WRITE_CNT)
+    fail ("%d completions for %d writes", done, WRITE_CNT);
+  close (fd);
+}
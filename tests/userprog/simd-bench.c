@@ -0,0 +1,143 @@
+/* Checksums a buffer with plain 32-bit adds and then with SSE2,
+   four lanes at a time, and reports the ticks each takes.  Then
+   forks several children that each park a different pattern in
+   the XMM registers and keep checking it while they are
+   preempted by one another, which shows that the kernel switches
+   SIMD state between processes. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define WORD_CNT 16384
+#define PASSES 200
+#define CHILD_CNT 4
+#define CHILD_TICKS 50
+
+static uint32_t buf[WORD_CNT] __attribute__ ((aligned (16)));
+
+static uint32_t
+sum_scalar (void) 
+{
+  uint32_t sum = 0;
+  size_t i;
+
+  for (i = 0; i < WORD_CNT; i++)
+    sum += buf[i];
+  return sum;
+}
+
+static uint32_t
+sum_sse (void) 
+{
+  uint32_t lanes[4] __attribute__ ((aligned (16)));
+  const uint32_t *p = buf, *end = buf + WORD_CNT;
+
+  asm volatile ("pxor %%xmm0, %%xmm0\n"
+                "pxor %%xmm1, %%xmm1\n"
+                "1:\n"
+                "paddd (%0), %%xmm0\n"
+                "paddd 16(%0), %%xmm1\n"
+                "addq $32, %0\n"
+                "cmpq %1, %0\n"
+                "jb 1b\n"
+                "paddd %%xmm1, %%xmm0\n"
+                "movdqa %%xmm0, (%2)\n"
+                : "+r" (p) : "r" (end), "r" (lanes) : "memory", "cc");
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+/* Loads PATTERN into xmm8 through xmm11.  The rest of the program
+   is built without SSE, so nothing else touches them. */
+static void
+load_pattern (const uint32_t *pattern) 
+{
+  asm volatile ("movdqa (%0), %%xmm8\n"
+                "movdqa %%xmm8, %%xmm9\n"
+                "movdqa %%xmm8, %%xmm10\n"
+                "movdqa %%xmm8, %%xmm11\n"
+                : : "r" (pattern) : "memory");
+}
+
+/* Returns true if xmm8 through xmm11 all still hold PATTERN. */
+static bool
+check_pattern (const uint32_t *pattern) 
+{
+  uint32_t mask;
+
+  asm volatile ("movdqa %%xmm8, %%xmm0\n"
+                "pand %%xmm9, %%xmm0\n"
+                "pand %%xmm10, %%xmm0\n"
+                "pand %%xmm11, %%xmm0\n"
+                "movdqa %%xmm8, %%xmm1\n"
+                "por %%xmm9, %%xmm1\n"
+                "por %%xmm10, %%xmm1\n"
+                "por %%xmm11, %%xmm1\n"
+                "pcmpeqd (%1), %%xmm0\n"
+                "pcmpeqd (%1), %%xmm1\n"
+                "pand %%xmm1, %%xmm0\n"
+                "pmovmskb %%xmm0, %0\n"
+                : "=r" (mask) : "r" (pattern) : "memory");
+  return mask == 0xffff;
+}
+
+/* Keeps a pattern unique to ID in the XMM registers for
+   CHILD_TICKS timer ticks, checking it all the while. */
+static int
+child (int id) 
+{
+  uint32_t pattern[4] __attribute__ ((aligned (16)));
+  long long start;
+  int i;
+
+  for (i = 0; i < 4; i++)
+    pattern[i] = 0x01010101u * (id + 1) + i;
+  load_pattern (pattern);
+
+  start = get_timer_ticks ();
+  while (get_timer_ticks () - start < CHILD_TICKS)
+    for (i = 0; i < 1000; i++)
+      if (!check_pattern (pattern))
+        return 1;
+  return 0;
+}
+
+void
+test_main (void) 
+{
+  pid_t pids[CHILD_CNT];
+  uint32_t expected, sum;
+  long long start;
+  int i;
+
+  for (i = 0; i < WORD_CNT; i++)
+    buf[i] = i * 2654435761u;
+  expected = sum_scalar ();
+
+  start = get_timer_ticks ();
+  for (i = 0; i < PASSES; i++)
+    sum = sum_scalar ();
+  msg ("scalar: %d passes in %lld ticks", PASSES, get_timer_ticks () - start);
+  if (sum != expected)
+    fail ("scalar checksum changed");
+
+  start = get_timer_ticks ();
+  for (i = 0; i < PASSES; i++)
+    sum = sum_sse ();
+  msg ("sse: %d passes in %lld ticks", PASSES, get_timer_ticks () - start);
+  if (sum != expected)
+    fail ("sse checksum %08x, expected %08x", sum, expected);
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      pids[i] = fork ("child");
+      if (pids[i] == 0)
+        exit (child (i));
+      if (pids[i] < 0)
+        fail ("fork failed");
+    }
+  for (i = 0; i < CHILD_CNT; i++)
+    if (wait (pids[i]) != 0)
+      fail ("child %d saw its registers change", i);
+}
@@ -0,0 +1,86 @@
+/* Launches child-simple LAUNCH_CNT times, one after another, with
+   fork() and exec(), with vfork() and exec(), and with spawn(), and
+   reports the ticks each way takes.  The parent first touches
+   DATA_SIZE bytes of memory, which fork() has to copy for every
+   child only for exec() to throw the copy away. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define LAUNCH_CNT 1000
+#define DATA_SIZE (1024 * 1024)
+#define PAGE_SIZE 4096
+
+static char data[DATA_SIZE];
+
+/* Starts child-simple with fork() and exec(). */
+static pid_t
+fork_exec (void) 
+{
+  pid_t pid = fork ("child-simple");
+  if (pid == 0)
+    {
+      exec ("child-simple");
+      fail ("exec failed");
+    }
+  return pid;
+}
+
+/* Starts child-simple with vfork() and exec(). */
+static pid_t
+vfork_exec (void) 
+{
+  pid_t pid = vfork ();
+  if (pid == 0)
+    {
+      exec ("child-simple");
+      exit (-1);
+    }
+  return pid;
+}
+
+/* Starts child-simple with spawn(). */
+static pid_t
+spawn_exec (void) 
+{
+  return spawn ("child-simple", NULL, 0);
+}
+
+/* Launches and waits for LAUNCH_CNT children with START and
+   reports the ticks it took. */
+static void
+run (const char *how, pid_t (*start) (void)) 
+{
+  long long ticks = get_timer_ticks ();
+  int i;
+
+  for (i = 0; i < LAUNCH_CNT; i++)
+    {
+      pid_t pid = start ();
+      if (pid < 0)
+        fail ("%s: launch %d failed", how, i);
+      if (wait (pid) != 81)
+        fail ("%s: child %d failed", how, i);
+    }
+  msg ("%s: %d children in %lld ticks", how, LAUNCH_CNT,
+       get_timer_ticks () - ticks);
+}
+
+void
+test_main (void) 
+{
+  struct spawn_action bad_dup = { SPAWN_DUP2, 5, 99, NULL };
+  size_t i;
+
+  for (i = 0; i < DATA_SIZE; i += PAGE_SIZE)
+    data[i] = 1;
+
+  CHECK (spawn ("no-such-file", NULL, 0) == -1, "spawn missing program");
+  CHECK (spawn ("child-simple", &bad_dup, 1) == -1,
+         "spawn with bad action");
+
+  run ("fork+exec", fork_exec);
+  run ("vfork+exec", vfork_exec);
+  run ("spawn", spawn_exec);
+}
@@ -0,0 +1,45 @@
+/* Times small reads and writes, which are dominated by system
+   call overhead and the copying of arguments to and from user
+   memory. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CALL_CNT 20000
+#define IO_SIZE 16
+
+static char buf[IO_SIZE];
+
+void
+test_main (void) 
+{
+  long long start;
+  int fd;
+  int i;
+
+  CHECK (create ("bench", IO_SIZE), "create \"bench\"");
+  CHECK ((fd = open ("bench")) > 1, "open \"bench\"");
+
+  start = get_timer_ticks ();
+  for (i = 0; i < CALL_CNT; i++)
+    {
+      seek (fd, 0);
+      if (write (fd, buf, sizeof buf) != sizeof buf)
+        fail ("write %d failed", i);
+    }
+  msg ("write: %d calls of %d bytes in %lld ticks", CALL_CNT, IO_SIZE,
+       get_timer_ticks () - start);
+
+  start = get_timer_ticks ();
+  for (i = 0; i < CALL_CNT; i++)
+    {
+      seek (fd, 0);
+      if (read (fd, buf, sizeof buf) != sizeof buf)
+        fail ("read %d failed", i);
+    }
+  msg ("read: %d calls of %d bytes in %lld ticks", CALL_CNT, IO_SIZE,
+       get_timer_ticks () - start);
+
+  close (fd);
+}
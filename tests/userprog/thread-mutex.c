@@ -0,0 +1,62 @@
+/* Several threads of one process increment a shared counter under
+   a futex-based mutex, then report to the initial thread through a
+   condition variable.  The counter must come out exact, and each
+   thread must be joinable with its exit status. */
+
+#include <futex.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define ITERATIONS 10000
+
+static struct mutex mutex = MUTEX_INITIALIZER;
+static struct condvar all_done = CONDVAR_INITIALIZER;
+static int counter;
+static int finished;
+
+static void
+worker (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      mutex_lock (&mutex);
+      counter++;
+      mutex_unlock (&mutex);
+    }
+
+  mutex_lock (&mutex);
+  if (++finished == THREAD_CNT)
+    condvar_signal (&all_done);
+  mutex_unlock (&mutex);
+}
+
+void
+test_main (void) 
+{
+  tid_t tids[THREAD_CNT];
+  bool ok = true;
+  int i;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      tids[i] = thread_create (worker, NULL);
+      ok = ok && tids[i] != TID_ERROR;
+    }
+  CHECK (ok, "create %d threads", THREAD_CNT);
+
+  mutex_lock (&mutex);
+  while (finished < THREAD_CNT)
+    condvar_wait (&all_done, &mutex);
+  mutex_unlock (&mutex);
+  msg ("all threads finished");
+
+  for (i = 0; i < THREAD_CNT; i++)
+    ok = ok && thread_join (tids[i]) == 0;
+  CHECK (ok, "join %d threads", THREAD_CNT);
+  CHECK (thread_join (tids[0]) == -1, "join a thread twice");
+  CHECK (counter == THREAD_CNT * ITERATIONS, "counter is %d", counter);
+}
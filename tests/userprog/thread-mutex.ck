@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-mutex) begin
+(thread-mutex) create 4 threads
+(thread-mutex) all threads finished
+(thread-mutex) join 4 threads
+(thread-mutex) join a thread twice
+(thread-mutex) counter is 40000
+(thread-mutex) end
+thread-mutex: exit(0)
+EOF
+pass;
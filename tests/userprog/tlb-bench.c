@@ -0,0 +1,87 @@
+/* Bounces a token between a parent and a child process over two
+   pipes, so that every round trip is two switches between address
+   spaces.  Between switches each side touches one byte in each of
+   PAGE_CNT pages, once with a single page and once with many, and
+   the test reports the ticks each run takes.  The gap between the
+   two shows how much the TLB refills after a switch cost. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ROUNDS 2000
+#define PAGE_CNT 64
+#define PAGE_SIZE 4096
+
+static char pages[PAGE_CNT][PAGE_SIZE];
+
+/* Touches the first CNT pages. */
+static void
+touch (int cnt) 
+{
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    pages[i][i]++;
+}
+
+/* Passes the token ROUNDS times: waits for it on RD, touches CNT
+   pages, and sends it back on WR.  The side that STARTS sends it
+   first. */
+static void
+play (int rd, int wr, int cnt, bool starts) 
+{
+  char token = 't';
+  int i;
+
+  for (i = 0; i < ROUNDS; i++)
+    {
+      if (starts && write (wr, &token, 1) != 1)
+        fail ("write failed");
+      if (read (rd, &token, 1) != 1)
+        fail ("read failed");
+      touch (cnt);
+      if (!starts && write (wr, &token, 1) != 1)
+        fail ("write failed");
+    }
+}
+
+static void
+run (int cnt) 
+{
+  int ping[2], pong[2];
+  long long start;
+  pid_t pid;
+
+  CHECK (pipe (ping) == 0 && pipe (pong) == 0, "create pipes");
+  touch (PAGE_CNT);
+
+  start = get_timer_ticks ();
+  pid = fork ("pong");
+  if (pid == 0)
+    {
+      close (ping[1]);
+      close (pong[0]);
+      play (ping[0], pong[1], cnt, false);
+      exit (0);
+    }
+  if (pid < 0)
+    fail ("fork failed");
+  close (ping[0]);
+  close (pong[1]);
+  play (pong[0], ping[1], cnt, true);
+  if (wait (pid) != 0)
+    fail ("child failed");
+  msg ("%d round trips touching %d pages: %lld ticks", ROUNDS, cnt,
+       get_timer_ticks () - start);
+
+  close (ping[1]);
+  close (pong[0]);
+}
+
+void
+test_main (void) 
+{
+  run (1);
+  run (PAGE_CNT);
+}
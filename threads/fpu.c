@@ -0,0 +1,170 @@
+#include "threads/fpu.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+/* Lazy x87/SSE state switching.
+
+   The kernel itself is built with -mno-sse -msoft-float and never
+   touches these registers, so only user code does.  Most threads
+   never use them at all, so instead of saving and restoring the
+   state on every switch, we leave it in the registers and set
+   CR0.TS whenever a thread other than its owner is scheduled.  The
+   first x87 or SSE instruction that thread executes then raises
+   #NM, and fpu_trap() moves the state over.
+
+   The save area is the 512-byte FXSAVE image, allocated when a
+   thread first needs it.  XSAVE would also cover AVX, but needs
+   CPU support that the emulated machine does not advertise. */
+
+#define CR0_MP 0x00000002           /* Monitor coprocessor. */
+#define CR0_EM 0x00000004           /* Emulate x87. */
+#define CR0_TS 0x00000008           /* Task switched. */
+#define CR4_OSFXSR 0x00000200       /* FXSAVE/FXRSTOR and SSE enabled. */
+#define CR4_OSXMMEXCPT 0x00000400   /* Unmasked SSE exceptions raise #XF. */
+
+#define FPU_AREA_SIZE 512           /* Size of an FXSAVE image. */
+#define FPU_AREA_ALIGN 16           /* Required alignment of the image. */
+
+/* Thread whose state is in the registers, or null. */
+static struct thread *fpu_owner;
+
+/* Whether CR0.TS is set, to avoid reading CR0 on every switch. */
+static bool ts_set;
+
+/* State right after FNINIT, given to each thread on first use. */
+static uint8_t initial_area[FPU_AREA_SIZE]
+	__attribute__ ((aligned (FPU_AREA_ALIGN)));
+
+/* Returns T's save area.  malloc() only aligns to 8 bytes, so the
+   block is over-allocated and rounded up here. */
+static void *
+fpu_area (struct thread *t) {
+	return (void *) ROUND_UP ((uintptr_t) t->fpu, FPU_AREA_ALIGN);
+}
+
+static void *
+fpu_area_alloc (void) {
+	return malloc (FPU_AREA_SIZE + FPU_AREA_ALIGN - 1);
+}
+
+static void
+fxsave (void *area) {
+	asm volatile ("fxsave64 (%0)" : : "r" (area) : "memory");
+}
+
+static void
+fxrstor (const void *area) {
+	asm volatile ("fxrstor64 (%0)" : : "r" (area) : "memory");
+}
+
+static void
+set_ts (bool on) {
+	if (on == ts_set)
+		return;
+	if (on)
+		lcr0 (rcr0 () | CR0_TS);
+	else
+		clts ();
+	ts_set = on;
+}
+
+/* Enables x87 and SSE instructions and records the initial
+   state handed out to new users. */
+void
+fpu_init (void) {
+	lcr0 ((rcr0 () & ~CR0_EM) | CR0_MP);
+	lcr4 (rcr4 () | CR4_OSFXSR | CR4_OSXMMEXCPT);
+	asm volatile ("fninit");
+	fxsave (initial_area);
+
+	ts_set = false;
+	set_ts (true);
+}
+
+/* Called by the scheduler, with interrupts off, before NEXT
+   runs.  Traps NEXT's first x87/SSE instruction unless its state
+   is already loaded. */
+void
+fpu_switch (struct thread *next) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	set_ts (next != fpu_owner);
+}
+
+/* Handles #NM for the running thread: saves the previous owner's
+   state and loads ours, allocating it on first use.  Returns
+   false if we are out of memory. */
+bool
+fpu_trap (void) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	if (cur->fpu == NULL) {
+		cur->fpu = fpu_area_alloc ();
+		if (cur->fpu == NULL)
+			return false;
+		memcpy (fpu_area (cur), initial_area, FPU_AREA_SIZE);
+	}
+
+	old_level = intr_disable ();
+	set_ts (false);
+	if (fpu_owner != cur) {
+		if (fpu_owner != NULL)
+			fxsave (fpu_area (fpu_owner));
+		fxrstor (fpu_area (cur));
+		fpu_owner = cur;
+	}
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Gives DST, the running thread, a copy of SRC's state, for
+   fork().  Returns false if we are out of memory. */
+bool
+fpu_copy (struct thread *dst, struct thread *src) {
+	enum intr_level old_level;
+
+	ASSERT (dst == thread_current ());
+
+	if (src->fpu == NULL)
+		return true;
+	dst->fpu = fpu_area_alloc ();
+	if (dst->fpu == NULL)
+		return false;
+
+	old_level = intr_disable ();
+	if (fpu_owner == src) {
+		/* SRC's latest state is still in the registers. */
+		set_ts (false);
+		fxsave (fpu_area (src));
+		set_ts (true);
+	}
+	intr_set_level (old_level);
+
+	memcpy (fpu_area (dst), fpu_area (src), FPU_AREA_SIZE);
+	return true;
+}
+
+/* Drops T's state, so that its next use starts afresh.  T must
+   be the running thread. */
+void
+fpu_release (struct thread *t) {
+	enum intr_level old_level;
+
+	ASSERT (t == thread_current ());
+
+	old_level = intr_disable ();
+	if (fpu_owner == t) {
+		fpu_owner = NULL;
+		set_ts (true);
+	}
+	intr_set_level (old_level);
+
+	free (t->fpu);
+	t->fpu = NULL;
+}
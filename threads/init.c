@@ -13,6 +13,7 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
@@ -37,6 +38,9 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#include "intrinsic.h"
+
+#define CR0_WP 0x00010000           /* Kernel writes obey PTE_W. */
 
 /* Page-map-level-4 with kernel mappings only. */
 uint64_t *base_pml4;
@@ -72,6 +76,7 @@ main (void) {
 
 	/* Clear BSS and get machine's RAM size. */
 	bss_init ();
+	string_init ();
 
 	/* Break command line into arguments and parse options. */
 	argv = read_command_line ();
@@ -86,14 +91,20 @@ main (void) {
 	mem_end = palloc_init ();
 	malloc_init ();
 	paging_init (mem_end);
+	pml4_pcid_init ();
 
 #ifdef USERPROG
 	tss_init ();
 	gdt_init ();
+	/* Make the kernel honor read-only user pages, so that a system
+	   call cannot write through a shared text page.  This waits for
+	   the final GDT, because the boot GDT is now read-only. */
+	lcr0 (rcr0 () | CR0_WP);
 #endif
 
 	/* Initialize interrupt handlers. */
 	intr_init ();
+	fpu_init ();
 	timer_init ();
 	kbd_init ();
 	input_init ();
@@ -155,6 +166,17 @@ paging_init (uint64_t mem_end) {
 	for (uint64_t pa = 0; pa < mem_end; pa += PGSIZE) {
 		uint64_t va = (uint64_t) ptov(pa);
 
+		// Use a huge page wherever one fits, except over the kernel
+		// text, which must stay read-only page by page.
+		if (pa % HPGSIZE == 0 && pa + HPGSIZE <= mem_end
+				&& (va + HPGSIZE <= (uint64_t) &start
+					|| va >= (uint64_t) &_end_kernel_text)) {
+			if ((pte = pml4e_walk_pde (pml4, va, 1)) != NULL)
+				*pte = pa | PTE_P | PTE_W | PTE_PS;
+			pa += HPGSIZE - PGSIZE;
+			continue;
+		}
+
 		perm = PTE_P | PTE_W;
 		if ((uint64_t) &start <= va && va < (uint64_t) &_end_kernel_text)
 			perm &= ~PTE_W;
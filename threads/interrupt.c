@@ -372,6 +372,14 @@ intr_handler (struct intr_frame *frame) {
 		if (yield_on_return)
 			thread_yield ();
 	}
+
+#ifdef USERPROG
+	/* A thread whose process is exiting must not resume user code. */
+	if (frame->cs == SEL_UCSEG && thread_current ()->killed) {
+		intr_enable ();
+		thread_exit ();
+	}
+#endif
 }
 
 /* Dumps interrupt frame F to the console, for debugging. */
@@ -2,17 +2,44 @@
 #include <stddef.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "intrinsic.h"
 
+/* Splits the huge page mapped by PDE into a page table of
+ * ordinary pages with the same frames and permissions.  The
+ * translations do not change, so the caller need only invalidate
+ * the TLB for the pages it goes on to modify; that drops the huge
+ * entry too.  Returns false if out of memory. */
+static bool
+demote (uint64_t *pde) {
+	uint64_t *pt = palloc_get_page (0);
+	uint64_t pa = PTE_ADDR (*pde);
+	uint64_t flags = *pde & PTE_FLAGS & ~PTE_PS;
+
+	if (pt == NULL)
+		return false;
+	for (unsigned i = 0; i < HPGCNT; i++)
+		pt[i] = (pa + i * PGSIZE) | flags;
+	*pde = vtop (pt) | PTE_U | PTE_W | PTE_P;
+	return true;
+}
+
+/* Returns the page table entry for VA in page directory PDP, or
+ * the page directory entry if WANT_PDE is true.  A huge page in the way
+ * of a page table entry is demoted first. */
 static uint64_t *
-pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
+pgdir_walk (uint64_t *pdp, const uint64_t va, int create, bool want_pde) {
 	int idx = PDX (va);
 	if (pdp) {
 		uint64_t *pte = (uint64_t *) pdp[idx];
+		if (want_pde)
+			return &pdp[idx];
+		if (((uint64_t) pte & PTE_PS) && !demote (&pdp[idx]))
+			return NULL;
 		if (!((uint64_t) pte & PTE_P)) {
 			if (create) {
 				uint64_t *new_page = palloc_get_page (PAL_ZERO);
@@ -29,7 +56,7 @@ pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 }
 
 static uint64_t *
-pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
+pdpe_walk (uint64_t *pdpe, const uint64_t va, int create, bool want_pde) {
 	uint64_t *pte = NULL;
 	int idx = PDPE (va);
 	int allocated = 0;
@@ -46,7 +73,7 @@ pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
 			} else
 				return NULL;
 		}
-		pte = pgdir_walk (ptov (PTE_ADDR (pdpe[idx])), va, create);
+		pte = pgdir_walk (ptov (PTE_ADDR (pdpe[idx])), va, create, want_pde);
 	}
 	if (pte == NULL && allocated) {
 		palloc_free_page ((void *) ptov (PTE_ADDR (pdpe[idx])));
@@ -55,14 +82,8 @@ pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
 	return pte;
 }
 
-/* Returns the address of the page table entry for virtual
- * address VADDR in page map level 4, pml4.
- * If PML4E does not have a page table for VADDR, behavior depends
- * on CREATE.  If CREATE is true, then a new page table is
- * created and a pointer into it is returned.  Otherwise, a null
- * pointer is returned. */
-uint64_t *
-pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
+static uint64_t *
+walk (uint64_t *pml4e, const uint64_t va, int create, bool want_pde) {
 	uint64_t *pte = NULL;
 	int idx = PML4 (va);
 	int allocated = 0;
@@ -79,7 +100,7 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 			} else
 				return NULL;
 		}
-		pte = pdpe_walk (ptov (PTE_ADDR (pml4e[idx])), va, create);
+		pte = pdpe_walk (ptov (PTE_ADDR (pml4e[idx])), va, create, want_pde);
 	}
 	if (pte == NULL && allocated) {
 		palloc_free_page ((void *) ptov (PTE_ADDR (pml4e[idx])));
@@ -88,6 +109,43 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 	return pte;
 }
 
+/* Returns the address of the page table entry for virtual
+ * address VADDR in page map level 4, pml4.
+ * If PML4E does not have a page table for VADDR, behavior depends
+ * on CREATE.  If CREATE is true, then a new page table is
+ * created and a pointer into it is returned.  Otherwise, a null
+ * pointer is returned.  If VADDR lies in a huge page, the huge
+ * page is first split into ordinary ones. */
+uint64_t *
+pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
+	return walk (pml4e, va, create, false);
+}
+
+/* Like pml4e_walk(), but returns the page directory entry for
+ * VADDR, which maps a huge page if is_huge_pte() is true, and
+ * never splits it. */
+uint64_t *
+pml4e_walk_pde (uint64_t *pml4e, const uint64_t va, int create) {
+	return walk (pml4e, va, create, true);
+}
+
+/* Returns the page directory entry for VADDR in PML4 if it maps
+ * a huge page, otherwise a null pointer. */
+static uint64_t *
+huge_pde (uint64_t *pml4, const void *vaddr) {
+	uint64_t *pde = pml4e_walk_pde (pml4, (uint64_t) vaddr, false);
+	return pde != NULL && (*pde & PTE_P) && is_huge_pte (pde) ? pde : NULL;
+}
+
+/* Returns the entry that maps VADDR in PML4: the page directory
+ * entry for a huge page, otherwise the page table entry.  Their
+ * accessed and dirty bits sit in the same place. */
+static uint64_t *
+leaf_walk (uint64_t *pml4, const void *vaddr) {
+	uint64_t *pde = huge_pde (pml4, vaddr);
+	return pde != NULL ? pde : pml4e_walk (pml4, (uint64_t) vaddr, false);
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -122,10 +180,18 @@ pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
-			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
-					pml4_index, pdp_index, i))
+		if (!(((uint64_t) pte) & PTE_P))
+			continue;
+		if (is_huge_pte (&pdp[i])) {
+			/* FUNC sees the page directory entry itself. */
+			void *va = (void *) (((uint64_t) pml4_index << PML4SHIFT) |
+								 ((uint64_t) pdp_index << PDPESHIFT) |
+								 ((uint64_t) i << PDXSHIFT));
+			if (!func (&pdp[i], va, aux))
 				return false;
+		} else if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
+					pml4_index, pdp_index, i))
+			return false;
 	}
 	return true;
 }
@@ -159,7 +225,7 @@ static void
 pt_destroy (uint64_t *pt) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pt[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if ((((uint64_t) pte) & PTE_P) && !is_shared_pte (&pt[i]))
 			palloc_free_page ((void *) PTE_ADDR (pte));
 	}
 	palloc_free_page ((void *) pt);
@@ -169,7 +235,11 @@ static void
 pgdir_destroy (uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if (!(((uint64_t) pte) & PTE_P))
+			continue;
+		if (is_huge_pte (&pdp[i]))
+			palloc_free_multiple ((void *) PTE_ADDR (pte), HPGCNT);
+		else
 			pt_destroy (PTE_ADDR (pte));
 	}
 	palloc_free_page ((void *) pdp);
@@ -185,12 +255,127 @@ pdpe_destroy (uint64_t *pdpe) {
 	palloc_free_page ((void *) pdpe);
 }
 
-/* Destroys pml4e, freeing all the pages it references. */
+/* Process-context identifiers.
+ *
+ * With CR4.PCIDE set, the low 12 bits of CR3 tag every TLB entry
+ * with the address space that created it, and a CR3 load with
+ * CR3_NOFLUSH set keeps the entries of all address spaces.  So
+ * switching back to a process finds its translations still cached.
+ *
+ * PCIDs are handed out from a small pool, round-robin, to page
+ * tables as they are activated; PCID 0 belongs to base_pml4.  When
+ * a PCID is taken over, its first load flushes whatever the old
+ * owner left behind.  A mapping changed in a page table that is
+ * not loaded is invalidated with INVPCID, or, where the CPU lacks
+ * it, by marking the PCID stale so that its next load flushes. */
+#define CR4_PCIDE (1 << 17)         /* PCIDs enabled. */
+#define CR3_PCID_MASK 0xfff         /* PCID part of CR3. */
+#define CR3_NOFLUSH (1ULL << 63)    /* Keep TLB entries on load. */
+#define PCID_CNT 32                 /* Size of the pool, counting 0. */
+
+struct pcid_slot {
+	uint64_t *pml4;                 /* Page table using the PCID, or null. */
+	bool stale;                     /* Must flush on next load. */
+};
+
+static bool pcid_enabled;
+static bool invpcid_enabled;
+static struct pcid_slot pcid_slots[PCID_CNT];
+static unsigned pcid_next = 1;      /* Next PCID to hand out. */
+
+/* Enables PCIDs if the CPU supports them. */
+void
+pml4_pcid_init (void) {
+	uint32_t eax, ebx, ecx, edx;
+
+	cpuid (1, 0, &eax, &ebx, &ecx, &edx);
+	if (!(ecx & (1 << 17)))
+		return;
+	cpuid (0, 0, &eax, &ebx, &ecx, &edx);
+	if (eax >= 7) {
+		cpuid (7, 0, &eax, &ebx, &ecx, &edx);
+		invpcid_enabled = (ebx & (1 << 10)) != 0;
+	}
+
+	/* Only allowed while CR3 holds PCID 0, which it does. */
+	ASSERT ((rcr3 () & CR3_PCID_MASK) == 0);
+	lcr4 (rcr4 () | CR4_PCIDE);
+	pcid_slots[0].pml4 = base_pml4;
+	pcid_enabled = true;
+}
+
+/* Returns PML4's PCID, or 0 if it has none. */
+static unsigned
+pcid_find (uint64_t *pml4) {
+	for (unsigned pcid = 1; pcid < PCID_CNT; pcid++)
+		if (pcid_slots[pcid].pml4 == pml4)
+			return pcid;
+	return 0;
+}
+
+/* Gives PML4 a PCID, taking it from its previous owner if any,
+ * and returns it.  The PCID loaded right now is never taken. */
+static unsigned
+pcid_alloc (uint64_t *pml4) {
+	unsigned cur = rcr3 () & CR3_PCID_MASK;
+	unsigned pcid;
+
+	do {
+		pcid = pcid_next;
+		pcid_next = pcid_next % (PCID_CNT - 1) + 1;
+	} while (pcid == cur);
+
+	pcid_slots[pcid].pml4 = pml4;
+	pcid_slots[pcid].stale = true;
+	return pcid;
+}
+
+/* Returns true if PML4 is the page table in CR3. */
+static bool
+is_active (uint64_t *pml4) {
+	return (rcr3 () & ~(uint64_t) CR3_PCID_MASK) == vtop (pml4);
+}
+
+/* Drops the TLB entry for VA in PML4, if any. */
+static void
+tlb_invalidate (uint64_t *pml4, const void *va) {
+	enum intr_level old_level;
+	unsigned pcid;
+
+	if (is_active (pml4)) {
+		invlpg ((uint64_t) va);
+		return;
+	}
+	if (!pcid_enabled)
+		return;
+
+	old_level = intr_disable ();
+	pcid = pcid_find (pml4);
+	if (pcid != 0) {
+		if (invpcid_enabled)
+			invpcid (0, pcid, (uint64_t) va);
+		else
+			pcid_slots[pcid].stale = true;
+	}
+	intr_set_level (old_level);
+}
+
+/* Destroys pml4e, freeing all the pages it references, except
+ * those marked shared. */
 void
 pml4_destroy (uint64_t *pml4) {
 	if (pml4 == NULL)
 		return;
 	ASSERT (pml4 != base_pml4);
+	ASSERT (!is_active (pml4));
+
+	if (pcid_enabled) {
+		enum intr_level old_level = intr_disable ();
+		unsigned pcid = pcid_find (pml4);
+		if (pcid != 0)
+			pcid_slots[pcid].pml4 = NULL;
+		intr_set_level (old_level);
+	}
 
 	/* if PML4 (vaddr) >= 1, it's kernel space by define. */
 	uint64_t *pdpe = ptov ((uint64_t *) pml4[0]);
@@ -200,10 +385,31 @@ pml4_destroy (uint64_t *pml4) {
 }
 
 /* Loads page directory PD into the CPU's page directory base
- * register. */
+ * register.  Nothing is flushed if PD is already loaded, or if it
+ * has a PCID whose TLB entries are still good. */
 void
 pml4_activate (uint64_t *pml4) {
-	lcr3 (vtop (pml4 ? pml4 : base_pml4));
+	enum intr_level old_level;
+	uint64_t cr3;
+	unsigned pcid = 0;
+	bool flush = false;
+
+	if (pml4 == NULL)
+		pml4 = base_pml4;
+
+	old_level = intr_disable ();
+	if (pcid_enabled && pml4 != base_pml4) {
+		pcid = pcid_find (pml4);
+		if (pcid == 0)
+			pcid = pcid_alloc (pml4);
+		flush = pcid_slots[pcid].stale;
+		pcid_slots[pcid].stale = false;
+	}
+
+	cr3 = vtop (pml4) | pcid;
+	if (flush || rcr3 () != cr3)
+		lcr3 (pcid_enabled && !flush ? cr3 | CR3_NOFLUSH : cr3);
+	intr_set_level (old_level);
 }
 
 /* Looks up the physical address that corresponds to user virtual
@@ -214,6 +420,10 @@ void *
 pml4_get_page (uint64_t *pml4, const void *uaddr) {
 	ASSERT (is_user_vaddr (uaddr));
 
+	uint64_t *pde = huge_pde (pml4, uaddr);
+	if (pde != NULL)
+		return ptov (PTE_ADDR (*pde)) + ((uint64_t) uaddr & (HPGSIZE - 1));
+
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
 	if (pte && (*pte & PTE_P))
@@ -257,18 +467,49 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
 
 	if (pte != NULL && (*pte & PTE_P) != 0) {
 		*pte &= ~PTE_P;
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) upage);
+		tlb_invalidate (pml4, upage);
 	}
 }
 
+/* Like pml4_set_page(), but maps KPAGE read-only and marks it as
+ * shared, so that pml4_destroy() leaves it to its owner. */
+bool
+pml4_set_shared_page (uint64_t *pml4, void *upage, void *kpage) {
+	if (!pml4_set_page (pml4, upage, kpage, false))
+		return false;
+	*pml4e_walk (pml4, (uint64_t) upage, false) |= PTE_SHARED;
+	return true;
+}
+
+/* Maps the huge page at user virtual address UPAGE in PML4 to
+ * the HPGCNT frames at kernel virtual address KPAGE, which should
+ * come from palloc_get_huge().  Nothing may be mapped in the
+ * HPGSIZE bytes at UPAGE yet, not even an empty page table.
+ * If WRITABLE is true, the new page is read/write; otherwise it is
+ * read-only.  Returns true if successful, false if memory
+ * allocation failed or the range is in use. */
+bool
+pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	ASSERT ((uint64_t) upage % HPGSIZE == 0);
+	ASSERT (vtop (kpage) % HPGSIZE == 0);
+	ASSERT (is_user_vaddr (upage));
+	ASSERT (pml4 != base_pml4);
+
+	uint64_t *pde = pml4e_walk_pde (pml4, (uint64_t) upage, 1);
+
+	if (pde == NULL || (*pde & PTE_P))
+		return false;
+	*pde = vtop (kpage) | PTE_P | (rw ? PTE_W : 0) | PTE_U | PTE_PS;
+	return true;
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PML4 is dirty,
  * that is, if the page has been modified since the PTE was
  * installed.
  * Returns false if PML4 contains no PTE for VPAGE. */
 bool
 pml4_is_dirty (uint64_t *pml4, const void *vpage) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte = leaf_walk (pml4, vpage);
 	return pte != NULL && (*pte & PTE_D) != 0;
 }
 
@@ -276,15 +517,14 @@ pml4_is_dirty (uint64_t *pml4, const void *vpage) {
  * in PML4. */
 void
 pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte = leaf_walk (pml4, vpage);
 	if (pte) {
 		if (dirty)
 			*pte |= PTE_D;
 		else
 			*pte &= ~(uint32_t) PTE_D;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		tlb_invalidate (pml4, vpage);
 	}
 }
 
@@ -294,7 +534,7 @@ pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
  * PML4 contains no PTE for VPAGE. */
 bool
 pml4_is_accessed (uint64_t *pml4, const void *vpage) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte = leaf_walk (pml4, vpage);
 	return pte != NULL && (*pte & PTE_A) != 0;
 }
 
@@ -302,14 +542,13 @@ pml4_is_accessed (uint64_t *pml4, const void *vpage) {
    VPAGE in PD. */
 void
 pml4_set_accessed (uint64_t *pml4, const void *vpage, bool accessed) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte = leaf_walk (pml4, vpage);
 	if (pte) {
 		if (accessed)
 			*pte |= PTE_A;
 		else
 			*pte &= ~(uint32_t) PTE_A;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		tlb_invalidate (pml4, vpage);
 	}
 }
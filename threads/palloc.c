@@ -284,6 +284,40 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	return pages;
 }
 
+/* Obtains HPGCNT contiguous free pages, aligned to HPGSIZE so
+   that they can be mapped as one huge page, and returns their
+   kernel virtual address.  FLAGS are as for palloc_get_multiple().
+   The pages are freed with palloc_free_multiple(), all at once or
+   in pieces. */
+void *
+palloc_get_huge (enum palloc_flags flags) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t page_cnt = bitmap_size (pool->used_map);
+	size_t page_idx;
+	void *pages = NULL;
+
+	/* Kernel virtual and physical addresses agree modulo HPGSIZE. */
+	page_idx = (HPGCNT - pg_no (pool->base) % HPGCNT) % HPGCNT;
+
+	lock_acquire (&pool->lock);
+	for (; page_idx + HPGCNT <= page_cnt; page_idx += HPGCNT)
+		if (bitmap_none (pool->used_map, page_idx, HPGCNT)) {
+			bitmap_set_multiple (pool->used_map, page_idx, HPGCNT, true);
+			pages = pool->base + PGSIZE * page_idx;
+			break;
+		}
+	lock_release (&pool->lock);
+
+	if (pages) {
+		if (flags & PAL_ZERO)
+			memset (pages, 0, HPGSIZE);
+	} else {
+		if (flags & PAL_ASSERT)
+			PANIC ("palloc_get: out of pages");
+	}
+	return pages;
+}
+
 /* Obtains a single free page and returns its kernel virtual
    address.
    If PAL_USER is set, the page is obtained from the user pool,
@@ -328,6 +362,15 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Returns the number of pages in use in the user pool if PAL_USER
+   is set in FLAGS, otherwise in the kernel pool.  Reads the pool
+   without locking, so the answer is only a snapshot. */
+size_t
+palloc_used_cnt (enum palloc_flags flags) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	return bitmap_count (pool->used_map, 0, bitmap_size (pool->used_map), true);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
@@ -360,6 +360,66 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 		cond_signal (cond, lock);
 }
 
+/* Initializes RW as an unheld readers-writer lock. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	lock_init (&rw->lock);
+	cond_init (&rw->readers_ok);
+	cond_init (&rw->writer_ok);
+	rw->readers = 0;
+	rw->writers_waiting = 0;
+	rw->writer = false;
+}
+
+/* Acquires RW for reading, sleeping until no writer holds it or
+ * waits for it. */
+void
+rwlock_acquire_read (struct rwlock *rw) {
+	lock_acquire (&rw->lock);
+	while (rw->writer || rw->writers_waiting > 0)
+		cond_wait (&rw->readers_ok, &rw->lock);
+	rw->readers++;
+	lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread holds for reading. */
+void
+rwlock_release_read (struct rwlock *rw) {
+	lock_acquire (&rw->lock);
+	ASSERT (rw->readers > 0);
+	if (--rw->readers == 0)
+		cond_signal (&rw->writer_ok, &rw->lock);
+	lock_release (&rw->lock);
+}
+
+/* Acquires RW for writing, sleeping until no reader or writer
+ * holds it. */
+void
+rwlock_acquire_write (struct rwlock *rw) {
+	lock_acquire (&rw->lock);
+	rw->writers_waiting++;
+	while (rw->writer || rw->readers > 0)
+		cond_wait (&rw->writer_ok, &rw->lock);
+	rw->writers_waiting--;
+	rw->writer = true;
+	lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread holds for writing. */
+void
+rwlock_release_write (struct rwlock *rw) {
+	lock_acquire (&rw->lock);
+	ASSERT (rw->writer);
+	rw->writer = false;
+	if (rw->writers_waiting > 0)
+		cond_signal (&rw->writer_ok, &rw->lock);
+	else
+		cond_broadcast (&rw->readers_ok, &rw->lock);
+	lock_release (&rw->lock);
+}
+
 /* 
 Project 1 : cmp_sema_priority 
 Comparing semaphore_elem's thread priority
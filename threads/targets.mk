@@ -2,6 +2,8 @@ threads_SRC  = threads/init.c		# Main program.
 threads_SRC += threads/thread.c		# Thread management core.
 threads_SRC += threads/interrupt.c	# Interrupt core.
 threads_SRC += threads/intr-stubs.S	# Interrupt stubs.
+threads_SRC += threads/switch.S		# Context switch.
+threads_SRC += threads/fpu.c		# Lazy x87/SSE state switching.
 threads_SRC += threads/synch.c		# Synchronization.
 threads_SRC += threads/palloc.c		# Page allocator.
 threads_SRC += threads/malloc.c		# Subpage allocator.
@@ -5,13 +5,16 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/flags.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "intrinsic.h"
 #ifdef USERPROG
+#include "userprog/fdtable.h"
 #include "userprog/process.h"
 #endif
 
@@ -186,6 +189,7 @@ tid_t
 thread_create (const char *name, int priority,
 		thread_func *function, void *aux) {
 	struct thread *t;
+	struct switch_frame *sf;
 	tid_t tid;
 
 	ASSERT (function != NULL);
@@ -210,11 +214,20 @@ thread_create (const char *name, int priority,
 	t->tf.cs = SEL_KCSEG;
 	t->tf.eflags = FLAG_IF;
 
-	
-	t->fdt = palloc_get_multiple(PAL_ZERO,3);
-	if(t->fdt == NULL) return TID_ERROR;
-	t->fdt[0] = 1;
-	t->fdt[1] = 2;
+	/* Stack frame for switch_threads(), which "returns" into
+	 * switch_entry() the first time the thread is scheduled. */
+	sf = (struct switch_frame *) ((uint8_t *) t + PGSIZE) - 1;
+	sf->rbx = (uint64_t) &t->tf;
+	sf->rip = switch_entry;
+	t->switch_rsp = (uint64_t) sf;
+
+#ifdef USERPROG
+	t->fdt = fd_table_create ();
+	if (t->fdt == NULL) {
+		palloc_free_page (t);
+		return TID_ERROR;
+	}
+#endif
 	
 	/* Projcet 2 */
 	list_push_back (&thread_current()->children, &t->child_elem);
@@ -307,7 +320,8 @@ thread_exit (void) {
 #ifdef USERPROG
 	process_exit ();
 #endif
-	
+	fpu_release (curr);
+
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
@@ -453,6 +467,7 @@ init_thread (struct thread *t, const char *name, int priority) {
 
 	/* Project 2 */
 	t->exit_status = 0;
+	t->killed = false;
 	t->exec_file = NULL;
 	// for(int i=2;i<128;i++) t->fdt[i] = NULL;
 	// t->fd = 2; // 0은 stdin, 1은 stdout에 이미 할당
@@ -464,6 +479,10 @@ init_thread (struct thread *t, const char *name, int priority) {
 	sema_init(&t->load,0);
 	sema_init(&t->wait,0);
 	sema_init(&t->exit,0);
+#ifdef USERPROG
+	t->stack_slot = -1;
+	t->vfork_parent = NULL;
+#endif
 
 }
 
@@ -508,75 +527,6 @@ do_iret (struct intr_frame *tf) {
 			: : "g" ((uint64_t) tf) : "memory");
 }
 
-/* Switching the thread by activating the new thread's page
-   tables, and, if the previous thread is dying, destroying it.
-
-   At this function's invocation, we just switched from thread
-   PREV, the new thread is already running, and interrupts are
-   still disabled.
-
-   It's not safe to call printf() until the thread switch is
-   complete.  In practice that means that printf()s should be
-   added at the end of the function. */
-static void
-thread_launch (struct thread *th) {
-	uint64_t tf_cur = (uint64_t) &running_thread ()->tf;
-	uint64_t tf = (uint64_t) &th->tf;
-	ASSERT (intr_get_level () == INTR_OFF);
-
-	/* The main switching logic.
-	 * We first restore the whole execution context into the intr_frame
-	 * and then switching to the next thread by calling do_iret.
-	 * Note that, we SHOULD NOT use any stack from here
-	 * until switching is done. */
-	__asm __volatile (
-			/* Store registers that will be used. */
-			"push %%rax\n"
-			"push %%rbx\n"
-			"push %%rcx\n"
-			/* Fetch input once */
-			"movq %0, %%rax\n"
-			"movq %1, %%rcx\n"
-			"movq %%r15, 0(%%rax)\n"
-			"movq %%r14, 8(%%rax)\n"
-			"movq %%r13, 16(%%rax)\n"
-			"movq %%r12, 24(%%rax)\n"
-			"movq %%r11, 32(%%rax)\n"
-			"movq %%r10, 40(%%rax)\n"
-			"movq %%r9, 48(%%rax)\n"
-			"movq %%r8, 56(%%rax)\n"
-			"movq %%rsi, 64(%%rax)\n"
-			"movq %%rdi, 72(%%rax)\n"
-			"movq %%rbp, 80(%%rax)\n"
-			"movq %%rdx, 88(%%rax)\n"
-			"pop %%rbx\n"              // Saved rcx
-			"movq %%rbx, 96(%%rax)\n"
-			"pop %%rbx\n"              // Saved rbx
-			"movq %%rbx, 104(%%rax)\n"
-			"pop %%rbx\n"              // Saved rax
-			"movq %%rbx, 112(%%rax)\n"
-			"addq $120, %%rax\n"
-			"movw %%es, (%%rax)\n"
-			"movw %%ds, 8(%%rax)\n"
-			"addq $32, %%rax\n"
-			"call __next\n"         // read the current rip.
-			"__next:\n"
-			"pop %%rbx\n"
-			"addq $(out_iret -  __next), %%rbx\n"
-			"movq %%rbx, 0(%%rax)\n" // rip
-			"movw %%cs, 8(%%rax)\n"  // cs
-			"pushfq\n"
-			"popq %%rbx\n"
-			"mov %%rbx, 16(%%rax)\n" // eflags
-			"mov %%rsp, 24(%%rax)\n" // rsp
-			"movw %%ss, 32(%%rax)\n"
-			"mov %%rcx, %%rdi\n"
-			"call do_iret\n"
-			"out_iret:\n"
-			: : "g"(tf_cur), "g" (tf) : "memory"
-			);
-}
-
 /* Schedules a new process. At entry, interrupts must be off.
  * This function modify current thread's status to status and then
  * finds another thread to run and switches to it.
@@ -612,6 +562,7 @@ schedule (void) {
 	/* Activate the new address space. */
 	process_activate (next);
 #endif
+	fpu_switch (next);
 
 	if (curr != next) {
 		/* If the thread we switched from is dying, destroy its struct
@@ -626,9 +577,10 @@ schedule (void) {
 			list_push_back (&destruction_req, &curr->elem);
 		}
 
-		/* Before switching the thread, we first save the information
-		 * of current running. */
-		thread_launch (next);
+		/* Only the callee-saved registers need saving here.  The
+		 * full intr_frame path (do_iret) is left for a thread's
+		 * first launch and for returning to user mode. */
+		switch_threads (&curr->switch_rsp, next->switch_rsp);
 	}
 }
 
@@ -2,8 +2,12 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/process.h"
+#include "userprog/uaccess.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 #include "intrinsic.h"
 
 /* Number of page faults processed. */
@@ -11,6 +15,7 @@ static long long page_fault_cnt;
 
 static void kill (struct intr_frame *);
 static void page_fault (struct intr_frame *);
+static void device_not_available (struct intr_frame *);
 
 /* Registers handlers for interrupts that can be caused by user
    programs.
@@ -45,7 +50,7 @@ exception_init (void) {
 	intr_register_int (0, 0, INTR_ON, kill, "#DE Divide Error");
 	intr_register_int (1, 0, INTR_ON, kill, "#DB Debug Exception");
 	intr_register_int (6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
-	intr_register_int (7, 0, INTR_ON, kill,
+	intr_register_int (7, 0, INTR_ON, device_not_available,
 			"#NM Device Not Available Exception");
 	intr_register_int (11, 0, INTR_ON, kill, "#NP Segment Not Present");
 	intr_register_int (12, 0, INTR_ON, kill, "#SS Stack Fault Exception");
@@ -105,6 +110,15 @@ kill (struct intr_frame *f) {
 	}
 }
 
+/* #NM handler.  The running thread used an x87 or SSE
+   instruction while another thread's state was loaded; switch it
+   in and retry the instruction. */
+static void
+device_not_available (struct intr_frame *f) {
+	if (f->cs != SEL_UCSEG || !fpu_trap ())
+		kill (f);
+}
+
 /* Page fault handler.  This is a skeleton that must be filled in
    to implement virtual memory.  Some solutions to project 2 may
    also require modifying this code.
@@ -140,6 +154,17 @@ page_fault (struct intr_frame *f) {
 	write = (f->error_code & PF_W) != 0;
 	user = (f->error_code & PF_U) != 0;
 
+	/* Heap pages are allocated on first touch, whether by the
+	   process or by the kernel on its behalf. */
+	if (not_present && is_user_vaddr (fault_addr)
+			&& process_heap_fault (fault_addr))
+		return;
+
+	/* A fault on a user address inside one of the user access
+	   routines is reported to the routine's caller. */
+	if (!user && is_user_vaddr (fault_addr) && uaccess_fixup (f))
+		return;
+
 	/* Project 2 */
 	exit(-1);
 
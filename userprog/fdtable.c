@@ -0,0 +1,265 @@
+#include "userprog/fdtable.h"
+#include <debug.h>
+#include <round.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "filesys/pipe.h"
+#include "threads/malloc.h"
+
+/* Bits in one word of a descriptor bitmap. */
+#define FD_WORD_BITS 64
+
+/* Returns the number of bitmap words for CAP descriptors. */
+static inline int
+used_words (int cap) {
+	return DIV_ROUND_UP (cap, FD_WORD_BITS);
+}
+
+/* Marks FD as in use in T. */
+static void
+mark_used (struct fd_table *t, int fd) {
+	int w = fd / FD_WORD_BITS;
+
+	t->used[w] |= (uint64_t) 1 << (fd % FD_WORD_BITS);
+	if (t->used[w] == UINT64_MAX)
+		t->full |= (uint64_t) 1 << w;
+}
+
+/* Marks FD as free in T. */
+static void
+mark_free (struct fd_table *t, int fd) {
+	int w = fd / FD_WORD_BITS;
+
+	t->used[w] &= ~((uint64_t) 1 << (fd % FD_WORD_BITS));
+	t->full &= ~((uint64_t) 1 << w);
+}
+
+/* Returns true if FD is a descriptor in use in T. */
+static inline bool
+is_used (const struct fd_table *t, int fd) {
+	return (fd >= 0 && fd < t->cap
+			&& (t->used[fd / FD_WORD_BITS] >> (fd % FD_WORD_BITS)) & 1);
+}
+
+/* Doubles the capacity of T, whose lock the caller holds.
+ * Returns false if T is already at FD_MAX descriptors or memory is
+ * exhausted. */
+static bool
+grow (struct fd_table *t) {
+	int cap = t->cap * 2;
+	struct file **files;
+	uint64_t *used;
+
+	if (t->cap >= FD_MAX)
+		return false;
+	files = calloc (cap, sizeof *files);
+	used = calloc (used_words (cap), sizeof *used);
+	if (files == NULL || used == NULL) {
+		free (files);
+		free (used);
+		return false;
+	}
+	memcpy (files, t->files, t->cap * sizeof *files);
+	memcpy (used, t->used, used_words (t->cap) * sizeof *used);
+
+	if (t->files != t->inline_files)
+		free (t->files);
+	if (t->used != &t->inline_used)
+		free (t->used);
+	t->files = files;
+	t->used = used;
+	t->cap = cap;
+	return true;
+}
+
+/* Creates and returns a descriptor table with only the console
+ * descriptors in use.  Returns a null pointer if memory is
+ * exhausted. */
+struct fd_table *
+fd_table_create (void) {
+	struct fd_table *t = calloc (1, sizeof *t);
+	if (t == NULL)
+		return NULL;
+	lock_init (&t->lock);
+	t->files = t->inline_files;
+	t->used = &t->inline_used;
+	t->cap = FD_INLINE_CNT;
+	mark_used (t, STDIN_FILENO);
+	mark_used (t, STDOUT_FILENO);
+	return t;
+}
+
+/* Makes DST, a new table with only the console descriptors in
+ * use, hold a duplicate of each of SRC's files under the same
+ * descriptor.  Returns false if memory is exhausted, in which
+ * case DST may hold some of the duplicates. */
+bool
+fd_table_copy (struct fd_table *dst, struct fd_table *src) {
+	bool success = false;
+	int w;
+
+	/* DST is not shared yet, so only SRC needs locking. */
+	lock_acquire (&src->lock);
+	while (dst->cap < src->cap)
+		if (!grow (dst))
+			goto done;
+
+	for (w = 0; w < used_words (src->cap); w++) {
+		uint64_t bits = src->used[w];
+		while (bits != 0) {
+			int fd = w * FD_WORD_BITS + __builtin_ctzll (bits);
+			bits &= bits - 1;
+			if (src->files[fd] == NULL)
+				continue;
+			dst->files[fd] = file_duplicate (src->files[fd]);
+			if (dst->files[fd] == NULL)
+				goto done;
+			mark_used (dst, fd);
+		}
+	}
+	success = true;
+
+done:
+	lock_release (&src->lock);
+	return success;
+}
+
+/* Closes every file in T and frees T, which no other thread may
+ * be using any more.  T may be null. */
+void
+fd_table_destroy (struct fd_table *t) {
+	int w;
+
+	if (t == NULL)
+		return;
+	for (w = 0; w < used_words (t->cap); w++) {
+		uint64_t bits = t->used[w];
+		while (bits != 0) {
+			int fd = w * FD_WORD_BITS + __builtin_ctzll (bits);
+			bits &= bits - 1;
+			file_close (t->files[fd]);
+		}
+	}
+	if (t->files != t->inline_files)
+		free (t->files);
+	if (t->used != &t->inline_used)
+		free (t->used);
+	free (t);
+}
+
+/* Wakes every thread waiting on a pipe open in T. */
+void
+fd_table_wake_pipes (struct fd_table *t) {
+	int w;
+
+	lock_acquire (&t->lock);
+	for (w = 0; w < used_words (t->cap); w++) {
+		uint64_t bits = t->used[w];
+		while (bits != 0) {
+			int fd = w * FD_WORD_BITS + __builtin_ctzll (bits);
+			bits &= bits - 1;
+			if (t->files[fd] != NULL && file_get_pipe (t->files[fd]) != NULL)
+				pipe_wake (file_get_pipe (t->files[fd]));
+		}
+	}
+	lock_release (&t->lock);
+}
+
+/* Installs FILE in T under the lowest free descriptor, growing T
+ * if it is full.  Returns the descriptor, or -1 if T cannot grow
+ * any further. */
+int
+fd_install (struct fd_table *t, struct file *file) {
+	int w, fd;
+
+	ASSERT (file != NULL);
+
+	lock_acquire (&t->lock);
+	/* A partial last word never becomes full, so a clear bit past
+	 * the capacity means every descriptor below it is in use. */
+	for (;;) {
+		if (~t->full != 0) {
+			w = __builtin_ctzll (~t->full);
+			if (w < used_words (t->cap)) {
+				fd = w * FD_WORD_BITS + __builtin_ctzll (~t->used[w]);
+				if (fd < t->cap)
+					break;
+			}
+		}
+		if (!grow (t)) {
+			lock_release (&t->lock);
+			return -1;
+		}
+	}
+
+	t->files[fd] = file;
+	mark_used (t, fd);
+	lock_release (&t->lock);
+	return fd;
+}
+
+/* Installs FILE in T as descriptor FD, closing the file FD
+ * referred to before, if any.  Returns false if FD is a console
+ * descriptor or T cannot grow to hold it. */
+bool
+fd_install_at (struct fd_table *t, int fd, struct file *file) {
+	struct file *old = NULL;
+
+	ASSERT (file != NULL);
+
+	if (fd <= STDOUT_FILENO || fd >= FD_MAX)
+		return false;
+
+	lock_acquire (&t->lock);
+	while (fd >= t->cap)
+		if (!grow (t)) {
+			lock_release (&t->lock);
+			return false;
+		}
+	if (is_used (t, fd))
+		old = t->files[fd];
+	t->files[fd] = file;
+	mark_used (t, fd);
+	lock_release (&t->lock);
+
+	file_close (old);
+	return true;
+}
+
+/* Returns the file open as FD in T, or a null pointer if FD is not
+ * open or is a console descriptor.  The file stays open until the
+ * caller releases it with fd_put(), even if another thread closes
+ * FD in the meantime. */
+struct file *
+fd_get (struct fd_table *t, int fd) {
+	struct file *file;
+
+	lock_acquire (&t->lock);
+	file = is_used (t, fd) && t->files[fd] != NULL
+		? file_ref (t->files[fd]) : NULL;
+	lock_release (&t->lock);
+	return file;
+}
+
+/* Releases FILE, returned by fd_get().  FILE may be null. */
+void
+fd_put (struct file *file) {
+	file_close (file);
+}
+
+/* Removes FD from T and returns the file it referred to, which
+ * the caller must close.  Returns a null pointer if FD is not open
+ * or is a console descriptor, which cannot be removed. */
+struct file *
+fd_remove (struct fd_table *t, int fd) {
+	struct file *file;
+
+	lock_acquire (&t->lock);
+	file = is_used (t, fd) ? t->files[fd] : NULL;
+	if (file != NULL) {
+		t->files[fd] = NULL;
+		mark_free (t, fd);
+	}
+	lock_release (&t->lock);
+	return file;
+}
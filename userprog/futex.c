@@ -0,0 +1,120 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Number of wait queues.  Each futex hashes to one of them. */
+#define FUTEX_BUCKETS 64
+
+/* A wait queue, holding the waiters of every futex that hashes to
+ * it. */
+struct futex_bucket {
+	struct lock lock;           /* Guards WAITERS. */
+	struct list waiters;        /* List of struct futex_waiter. */
+};
+
+/* A thread blocked in futex_wait().
+ * A futex is named by the kernel address of its word, which
+ * identifies the frame and offset and so is the same in every
+ * address space that maps the frame. */
+struct futex_waiter {
+	struct list_elem elem;      /* Element in futex_bucket's WAITERS. */
+	const int32_t *key;         /* Kernel address of the futex word. */
+	struct thread *thread;      /* The waiting thread. */
+	struct semaphore sema;      /* Upped to wake the thread. */
+};
+
+static struct futex_bucket buckets[FUTEX_BUCKETS];
+
+/* Initializes the futex wait queues. */
+void
+futex_init (void) {
+	int i;
+
+	for (i = 0; i < FUTEX_BUCKETS; i++) {
+		lock_init (&buckets[i].lock);
+		list_init (&buckets[i].waiters);
+	}
+}
+
+/* Returns the wait queue for KEY. */
+static struct futex_bucket *
+futex_bucket (const int32_t *key) {
+	return &buckets[hash_ptr (key) % FUTEX_BUCKETS];
+}
+
+/* Blocks until futex_wake() is called on the futex word at kernel
+ * address KEY, if the word still holds VAL.  Returns 0 after being
+ * woken, or -1 at once if the word does not hold VAL. */
+int
+futex_wait (const int32_t *key, int32_t val) {
+	struct futex_bucket *b = futex_bucket (key);
+	struct futex_waiter w;
+
+	/* Checking the word and queueing under the bucket lock means a
+	 * waker that changes the word and then calls futex_wake()
+	 * either finds us queued or makes us see the new value. */
+	lock_acquire (&b->lock);
+	if (*(volatile const int32_t *) key != val) {
+		lock_release (&b->lock);
+		return -1;
+	}
+	w.key = key;
+	w.thread = thread_current ();
+	sema_init (&w.sema, 0);
+	list_push_back (&b->waiters, &w.elem);
+	lock_release (&b->lock);
+
+	sema_down (&w.sema);
+	return 0;
+}
+
+/* Wakes up to CNT threads waiting on the futex word at kernel
+ * address KEY, oldest first.  Returns the number woken. */
+int
+futex_wake (const int32_t *key, int cnt) {
+	struct futex_bucket *b = futex_bucket (key);
+	struct list_elem *e;
+	int woken = 0;
+
+	lock_acquire (&b->lock);
+	for (e = list_begin (&b->waiters);
+			e != list_end (&b->waiters) && woken < cnt; ) {
+		struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+		e = list_next (e);
+		if (w->key == key) {
+			list_remove (&w->elem);
+			sema_up (&w->sema);
+			woken++;
+		}
+	}
+	lock_release (&b->lock);
+	return woken;
+}
+
+/* Wakes every waiting thread that has been killed, so that it
+ * can exit. */
+void
+futex_wake_killed (void) {
+	int i;
+
+	for (i = 0; i < FUTEX_BUCKETS; i++) {
+		struct futex_bucket *b = &buckets[i];
+		struct list_elem *e;
+
+		lock_acquire (&b->lock);
+		for (e = list_begin (&b->waiters); e != list_end (&b->waiters); ) {
+			struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+			e = list_next (e);
+			if (w->thread->killed) {
+				list_remove (&w->elem);
+				sema_up (&w->sema);
+			}
+		}
+		lock_release (&b->lock);
+	}
+}
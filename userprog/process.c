@@ -5,14 +5,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "userprog/fdtable.h"
+#include "userprog/futex.h"
 #include "userprog/gdt.h"
+#include "userprog/textcache.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/flags.h"
+#include "threads/fpu.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
@@ -29,7 +34,15 @@
 static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
+static int wait_child (tid_t, bool user_thread);
 static void __do_fork (void *);
+static void __do_vfork (void *);
+static void spawn_child (void *);
+static void vfork_release (struct thread *);
+static void start_thread (void *);
+static bool thread_group_leave (struct thread *);
+static void heap_copy (struct thread *dst, struct thread *src);
+static bool exec_file_copy (struct thread *dst, struct thread *src);
 
 /* Project 2 */
 void argument_passing(char ** argv, int argc, struct intr_frame *if_);
@@ -97,7 +110,180 @@ process_fork (const char *name, struct intr_frame *if_) {
 	return pid;
 }
 
+/* Start-up information passed from process_spawn() to
+ * spawn_child(). */
+struct spawn_start {
+	struct thread *parent;      /* Thread calling process_spawn(). */
+	char *cmd_line;             /* Page holding the command line. */
+	struct fd_table *fdt;       /* Descriptors for the child. */
+	bool success;               /* Set by spawn_child(). */
+};
+
+/* Starts the program named by the first word of CMD_LINE in a new
+ * child process whose descriptors are FDT, without copying the
+ * current process as process_fork() and process_exec() would.
+ * Takes ownership of CMD_LINE, a page from palloc_get_page(), and
+ * of FDT.  Returns the child's thread id once the program is
+ * loaded, or TID_ERROR if it cannot be. */
+tid_t
+process_spawn (char *cmd_line, struct fd_table *fdt) {
+	struct thread *cur = thread_current ();
+	struct spawn_start start;
+	char name[16], *save_ptr;
+	tid_t tid;
+
+	strlcpy (name, cmd_line, sizeof name);
+	strtok_r (name, " ", &save_ptr);
+
+	start.parent = cur;
+	start.cmd_line = cmd_line;
+	start.fdt = fdt;
+	tid = thread_create (name, PRI_DEFAULT, spawn_child, &start);
+	if (tid == TID_ERROR) {
+		palloc_free_page (cmd_line);
+		fd_table_destroy (fdt);
+		return TID_ERROR;
+	}
+
+	/* START lives on our stack, so wait until it has been used. */
+	sema_down (&cur->load);
+	if (!start.success) {
+		process_wait (tid);
+		return TID_ERROR;
+	}
+	return tid;
+}
+
+/* A thread function that loads the program for process_spawn(). */
+static void
+spawn_child (void *aux) {
+	struct spawn_start *start = aux;
+	struct thread *cur = thread_current ();
+	struct intr_frame if_;
+	bool success;
+
+#ifdef VM
+	supplemental_page_table_init (&cur->spt);
+#endif
+	process_init ();
+
+	fd_table_destroy (cur->fdt);
+	cur->fdt = start->fdt;
+
+	memset (&if_, 0, sizeof if_);
+	if_.ds = if_.es = if_.ss = SEL_UDSEG;
+	if_.cs = SEL_UCSEG;
+	if_.eflags = FLAG_IF | FLAG_MBS;
+	success = load (start->cmd_line, &if_);
+	palloc_free_page (start->cmd_line);
+
+	/* Copy out of START before the parent may return. */
+	start->success = success;
+	sema_up (&start->parent->load);
+
+	if (success)
+		do_iret (&if_);
+	cur->exit_status = -1;
+	thread_exit ();
+}
+
+/* Clones the current process like process_fork(), except that the
+ * child borrows the current address space instead of copying it,
+ * and the caller is blocked until the child gives it back by
+ * calling exec or exiting.  Until then the child runs on the
+ * caller's stack, so it should do nothing else.  Returns the
+ * child's thread id, or TID_ERROR if the thread cannot be
+ * created. */
+tid_t
+process_vfork (struct intr_frame *if_) {
+	struct thread *cur = thread_current ();
+	tid_t pid;
+
+	memcpy (&cur->userland_if, if_, sizeof (struct intr_frame));
+	pid = thread_create (cur->name, PRI_DEFAULT, __do_vfork, cur);
+	if (pid == TID_ERROR)
+		return TID_ERROR;
+
+	sema_down (&cur->load);
+	return pid;
+}
+
+/* A thread function that enters user code in the address space of
+ * AUX, the thread calling process_vfork(). */
+static void
+__do_vfork (void *aux) {
+	struct thread *parent = aux;
+	struct thread *cur = thread_current ();
+	struct intr_frame if_;
+
+	memcpy (&if_, &parent->userland_if, sizeof (struct intr_frame));
+	if_.R.rax = 0;
+
+	cur->pml4 = parent->pml4;
+	cur->vfork_parent = parent;
+	process_activate (cur);
+#ifdef VM
+	supplemental_page_table_init (&cur->spt);
+#endif
+
+	if (!fd_table_copy (cur->fdt, parent->fdt) || !fpu_copy (cur, parent)) {
+		cur->exit_status = -1;
+		thread_exit ();
+	}
+	heap_copy (cur, parent);
+	process_init ();
+
+	do_iret (&if_);
+}
+
+/* If T, the running thread, is a vfork child, gives its address
+ * space back to the parent and lets the parent return. */
+static void
+vfork_release (struct thread *t) {
+	if (t->vfork_parent == NULL)
+		return;
+
+	t->pml4 = NULL;
+	pml4_activate (NULL);
+	sema_up (&t->vfork_parent->load);
+	t->vfork_parent = NULL;
+}
+
 #ifndef VM
+/* Copies the huge page that PDE maps at VA in PARENT to the same
+ * place in the current thread, as a huge page if one is free and
+ * page by page otherwise. */
+static bool
+duplicate_huge_pte (uint64_t *pde, void *va, struct thread *parent) {
+	struct thread *current = thread_current ();
+	uint8_t *parent_page = pml4_get_page (parent->pml4, va);
+	bool writable = is_writable (pde);
+	uint8_t *newpage;
+	unsigned i;
+
+	newpage = palloc_get_huge (PAL_USER);
+	if (newpage != NULL) {
+		memcpy (newpage, parent_page, HPGSIZE);
+		if (pml4_set_huge_page (current->pml4, va, newpage, writable))
+			return true;
+		palloc_free_multiple (newpage, HPGCNT);
+		return false;
+	}
+
+	for (i = 0; i < HPGCNT; i++) {
+		newpage = palloc_get_page (PAL_USER);
+		if (newpage == NULL)
+			return false;
+		memcpy (newpage, parent_page + i * PGSIZE, PGSIZE);
+		if (!pml4_set_page (current->pml4, (uint8_t *) va + i * PGSIZE,
+					newpage, writable)) {
+			palloc_free_page (newpage);
+			return false;
+		}
+	}
+	return true;
+}
+
 /* Duplicate the parent's address space by passing this function to the
  * pml4_for_each. This is only for the project 2. */
 static bool
@@ -111,6 +297,18 @@ duplicate_pte (uint64_t *pte, void *va, void *aux) {
 	/* 1. TODO: If the parent_page is kernel page, then return immediately. */
 	if (is_kernel_vaddr(va))
 		return true;
+	if (is_huge_pte (pte))
+		return duplicate_huge_pte (pte, va, parent);
+	if (is_shared_pte (pte)) {
+		/* Read-only text: map the same frame. */
+		parent_page = pml4_get_page (parent->pml4, va);
+		text_cache_dup (parent_page);
+		if (!pml4_set_shared_page (current->pml4, va, parent_page)) {
+			text_cache_put (parent_page);
+			return false;
+		}
+		return true;
+	}
 	/* 2. Resolve VA from the parent's page map level 4. */
 	parent_page = pml4_get_page (parent->pml4, va);
 	if (parent_page == NULL) return false;
@@ -176,21 +374,13 @@ static void
 	 * TODO:       from the fork() until this function successfully duplicates
 	 * TODO:       the resources of parent.*/
 
-	// for (int i = 2; i < 128; i++)
-	// {
-	// 		if(parent->fdt[i] !=NULL)
-	// 			current->fdt[i] = file_duplicate(parent->fdt[i]);
-	// }
-
-	for (int i = 0; i < 128; i++)
-    {
-        struct file *file = parent->fdt[i];
-        if (file == NULL)
-            continue;
-        if (file > 2)
-            file = file_duplicate(file);
-        current->fdt[i] = file;
-    }
+	if (!fd_table_copy (current->fdt, parent->fdt))
+		goto error;
+	heap_copy (current, parent);
+	if (!exec_file_copy (current, parent))
+		goto error;
+	if (!fpu_copy (current, parent))
+		goto error;
 
 	process_init ();
 	
@@ -205,12 +395,432 @@ error:
 	exit(TID_ERROR);
 }
 
+/* User threads.
+ *
+ * A process starts with one thread.  process_create_thread() adds
+ * more, which share its page table and descriptor table.  Each has
+ * a small stack of its own in a slot below the initial stack.  The
+ * threads of a process hold a reference to a struct thread_group.
+ * The initial thread is the last to leave it: on exiting, it waits
+ * for the others and then tears down what they share, so that the
+ * parent's wait() returns only once the whole process is gone.
+ *
+ * exit() ends the whole process.  It kills the other threads, which
+ * exit on their way back to user mode, waking those blocked on a
+ * futex or a pipe so that they get there. */
+
+/* Highest address of the first user thread stack slot, well below
+ * the initial stack. */
+#define THREAD_STACK_BASE (USER_STACK - 0x100000)
+
+/* Address space per stack slot.  Only THREAD_STACK_PAGES of it are
+ * mapped, so the rest catches overflows. */
+#define THREAD_STACK_SPAN 0x10000
+#define THREAD_STACK_PAGES 4
+
+/* What the threads of a multithreaded process share. */
+struct thread_group {
+	struct lock lock;           /* Guards all the members below. */
+	int refs;                   /* Threads using the address space. */
+	struct list members;        /* Threads, linked by group_elem. */
+	struct condition left;      /* Signaled when a thread leaves. */
+	bool exiting;               /* Has a thread called exit()? */
+	int exit_status;            /* Status passed to exit(). */
+	uint64_t stack_slots;       /* Bit set if the stack slot is in use. */
+	struct file *exec_file;     /* Executable, denied writes until the end. */
+	uintptr_t heap_start;       /* Start of heap. */
+	uintptr_t heap_brk;         /* End of heap. */
+};
+
+/* Start-up information passed from process_create_thread() to
+ * start_thread(). */
+struct thread_start {
+	struct thread *creator;     /* Thread calling process_create_thread(). */
+	struct intr_frame if_;      /* Initial user context. */
+	int slot;                   /* Stack slot. */
+	bool success;               /* Set by start_thread(). */
+};
+
+/* Returns the top of stack slot SLOT. */
+static uint8_t *
+stack_slot_top (int slot) {
+	return (uint8_t *) THREAD_STACK_BASE - (uint64_t) slot * THREAD_STACK_SPAN;
+}
+
+/* Unmaps and frees the stack pages of user thread T.  The caller
+ * must hold T's group lock. */
+static void
+free_thread_stack (struct thread *t) {
+	uint8_t *top = stack_slot_top (t->stack_slot);
+	int i;
+
+	for (i = 1; i <= THREAD_STACK_PAGES; i++) {
+		void *kpage = pml4_get_page (t->pml4, top - i * PGSIZE);
+		if (kpage != NULL) {
+			pml4_clear_page (t->pml4, top - i * PGSIZE);
+			palloc_free_page (kpage);
+		}
+	}
+}
+
+/* Starts a new thread in the current process that runs user code at
+ * ENTRY with ARG0 and ARG1 as its first two arguments, on a stack of
+ * its own.  Returns the new thread's id, or TID_ERROR if the thread
+ * cannot be created. */
+tid_t
+process_create_thread (void *entry, uint64_t arg0, uint64_t arg1) {
+	struct thread *cur = thread_current ();
+	struct thread_group *g = cur->group;
+	struct thread_start start;
+	tid_t tid;
+
+	if (g == NULL) {
+		g = malloc (sizeof *g);
+		if (g == NULL)
+			return TID_ERROR;
+		lock_init (&g->lock);
+		g->refs = 1;
+		list_init (&g->members);
+		list_push_back (&g->members, &cur->group_elem);
+		cond_init (&g->left);
+		g->exiting = false;
+		g->exit_status = 0;
+		g->stack_slots = 0;
+		g->exec_file = cur->exec_file;
+		g->heap_start = cur->heap_start;
+		g->heap_brk = cur->heap_brk;
+		cur->exec_file = NULL;
+		cur->group = g;
+	}
+
+	lock_acquire (&g->lock);
+	if (~g->stack_slots == 0) {
+		lock_release (&g->lock);
+		return TID_ERROR;
+	}
+	start.slot = __builtin_ctzll (~g->stack_slots);
+	g->stack_slots |= (uint64_t) 1 << start.slot;
+	g->refs++;
+	lock_release (&g->lock);
+
+	start.creator = cur;
+	memset (&start.if_, 0, sizeof start.if_);
+	start.if_.ds = start.if_.es = start.if_.ss = SEL_UDSEG;
+	start.if_.cs = SEL_UCSEG;
+	start.if_.eflags = FLAG_IF | FLAG_MBS;
+	start.if_.rip = (uintptr_t) entry;
+	start.if_.rsp = (uintptr_t) stack_slot_top (start.slot) - sizeof (void *);
+	start.if_.R.rdi = arg0;
+	start.if_.R.rsi = arg1;
+
+	tid = thread_create (cur->name, PRI_DEFAULT, start_thread, &start);
+	if (tid == TID_ERROR) {
+		lock_acquire (&g->lock);
+		g->stack_slots &= ~((uint64_t) 1 << start.slot);
+		g->refs--;
+		lock_release (&g->lock);
+		return TID_ERROR;
+	}
+
+	/* START lives on our stack, so wait until it has been used. */
+	sema_down (&cur->load);
+	return start.success ? tid : TID_ERROR;
+}
+
+/* A thread function that joins the creator's address space, maps
+ * a stack and enters user code. */
+static void
+start_thread (void *aux) {
+	struct thread_start *start = aux;
+	struct thread *creator = start->creator;
+	struct thread *cur = thread_current ();
+	struct intr_frame if_;
+	uint8_t *top = stack_slot_top (start->slot);
+	bool success = true;
+	int i;
+
+	fd_table_destroy (cur->fdt);
+	cur->fdt = creator->fdt;
+	cur->pml4 = creator->pml4;
+	cur->group = creator->group;
+	cur->stack_slot = start->slot;
+	process_activate (cur);
+
+	/* The other threads may be changing the page table too. */
+	lock_acquire (&cur->group->lock);
+	list_push_back (&cur->group->members, &cur->group_elem);
+	cur->killed = cur->group->exiting;
+	for (i = 1; i <= THREAD_STACK_PAGES && success; i++) {
+		void *kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+		if (kpage == NULL)
+			success = false;
+		else if (!pml4_set_page (cur->pml4, top - i * PGSIZE, kpage, true)) {
+			palloc_free_page (kpage);
+			success = false;
+		}
+	}
+	lock_release (&cur->group->lock);
+
+	/* Copy out of START before the creator may return. */
+	if_ = start->if_;
+	start->success = success;
+	sema_up (&creator->load);
+
+	if (success && !cur->killed)
+		do_iret (&if_);
+	cur->exit_status = -1;
+	thread_exit ();
+}
+
+/* Ends the process of the running thread, which is in a thread
+ * group, with STATUS: kills the other threads and wakes those that
+ * are blocked, so that they exit.  The termination message is left
+ * to the initial thread, which leaves the group last.  If another
+ * thread has already called exit(), its status stands. */
+void
+process_exit_group (int status) {
+	struct thread *cur = thread_current ();
+	struct thread_group *g = cur->group;
+	struct list_elem *e;
+
+	lock_acquire (&g->lock);
+	if (!g->exiting) {
+		g->exiting = true;
+		g->exit_status = status;
+		for (e = list_begin (&g->members); e != list_end (&g->members);
+				e = list_next (e))
+			list_entry (e, struct thread, group_elem)->killed = true;
+	}
+	lock_release (&g->lock);
+
+	futex_wake_killed ();
+	fd_table_wake_pipes (cur->fdt);
+}
+
+/* Drops thread T's reference to the address space it shares with
+ * other threads, freeing its stack.  The initial thread first waits
+ * for every other thread to leave.  Returns true if T was the last
+ * thread, in which case it inherits the executable and must tear
+ * down the address space and descriptor table itself, and prints
+ * the termination message if the process called exit(). */
+static bool
+thread_group_leave (struct thread *t) {
+	struct thread_group *g = t->group;
+	bool last;
+
+	lock_acquire (&g->lock);
+	if (t->stack_slot >= 0) {
+		free_thread_stack (t);
+		g->stack_slots &= ~((uint64_t) 1 << t->stack_slot);
+	}
+	else
+		while (g->refs > 1)
+			cond_wait (&g->left, &g->lock);
+	list_remove (&t->group_elem);
+	last = --g->refs == 0;
+	cond_signal (&g->left, &g->lock);
+	lock_release (&g->lock);
+
+	t->group = NULL;
+	if (!last)
+		return false;
+	if (g->exiting) {
+		t->exit_status = g->exit_status;
+		printf ("%s: exit(%d)\n", t->name, t->exit_status);
+	}
+	t->exec_file = g->exec_file;
+	t->heap_start = g->heap_start;
+	t->heap_brk = g->heap_brk;
+	free (g);
+	return true;
+}
+
+/* The heap.
+ *
+ * The heap starts at the page after the executable's last segment
+ * and ends at the break, which process_sbrk() moves.  Pages below
+ * the break are allocated on first touch by process_heap_fault(),
+ * so growing the heap costs nothing until it is used.  The threads
+ * of a process share one heap, kept in their thread group. */
+
+/* Highest address the break may reach, below the ring page and the
+ * user thread stacks. */
+#define HEAP_LIMIT (USER_STACK - 0x1000000)
+
+/* Locks T's heap bounds and returns pointers to them in *START and
+ * *BRK.  Must be followed by heap_unlock(). */
+static void
+heap_lock (struct thread *t, uintptr_t **start, uintptr_t **brk) {
+	if (t->group != NULL) {
+		lock_acquire (&t->group->lock);
+		*start = &t->group->heap_start;
+		*brk = &t->group->heap_brk;
+	} else {
+		*start = &t->heap_start;
+		*brk = &t->heap_brk;
+	}
+}
+
+/* Unlocks T's heap bounds. */
+static void
+heap_unlock (struct thread *t) {
+	if (t->group != NULL)
+		lock_release (&t->group->lock);
+}
+
+/* Gives DST, a new process, the same heap bounds as SRC. */
+static void
+heap_copy (struct thread *dst, struct thread *src) {
+	uintptr_t *start, *brk;
+
+	heap_lock (src, &start, &brk);
+	dst->heap_start = *start;
+	dst->heap_brk = *brk;
+	heap_unlock (src);
+}
+
+/* Gives DST, a new process, its own handle on SRC's executable,
+ * denied writes like SRC's, since DST maps the same shared text
+ * pages.  Returns false if out of memory. */
+static bool
+exec_file_copy (struct thread *dst, struct thread *src) {
+	struct file *file;
+
+	if (src->group != NULL) {
+		lock_acquire (&src->group->lock);
+		file = src->group->exec_file;
+		lock_release (&src->group->lock);
+	} else
+		file = src->exec_file;
+	if (file == NULL)
+		return true;
+
+	dst->exec_file = file_duplicate (file);
+	if (dst->exec_file == NULL)
+		return false;
+	file_deny_write (dst->exec_file);
+	return true;
+}
+
+/* Moves the current process's break by INCREMENT bytes and returns
+ * the old break, or (void *) -1 if the break would leave the heap.
+ * Pages wholly above a lowered break are freed. */
+void *
+process_sbrk (intptr_t increment) {
+	struct thread *cur = thread_current ();
+	uintptr_t *start, *brk, old, new;
+	bool ok;
+
+	heap_lock (cur, &start, &brk);
+	old = *brk;
+	new = old + increment;
+	if (increment >= 0)
+		ok = new >= old && new <= HEAP_LIMIT;
+	else
+		ok = new < old && new >= *start;
+	if (ok) {
+		uintptr_t page;
+
+		for (page = ROUND_UP (new, PGSIZE); page < old; page += PGSIZE) {
+			void *kpage = pml4_get_page (cur->pml4, (void *) page);
+			/* Clearing part of a huge page splits it, which can
+			 * fail, so check that the page really is gone. */
+			if (kpage != NULL) {
+				pml4_clear_page (cur->pml4, (void *) page);
+				if (pml4_get_page (cur->pml4, (void *) page) == NULL)
+					palloc_free_page (kpage);
+			}
+		}
+		*brk = new;
+	}
+	heap_unlock (cur);
+	return ok ? (void *) old : (void *) -1;
+}
+
+/* Maps a zeroed huge page at UPAGE in T's address space if
+ * nothing there is mapped yet.  Returns true if successful. */
+static bool
+heap_map_huge (struct thread *t, void *upage) {
+	uint64_t *pde = pml4e_walk_pde (t->pml4, (uint64_t) upage, false);
+	void *kpage;
+
+	if (pde != NULL && (*pde & PTE_P))
+		return false;
+	kpage = palloc_get_huge (PAL_USER | PAL_ZERO);
+	if (kpage == NULL)
+		return false;
+	if (!pml4_set_huge_page (t->pml4, upage, kpage, true)) {
+		palloc_free_multiple (kpage, HPGCNT);
+		return false;
+	}
+	return true;
+}
+
+/* Maps a zeroed page at FAULT_ADDR if it lies in the current
+ * process's heap and is not yet present.  Returns true if the
+ * faulting access can be retried.
+ *
+ * Where the heap covers a whole aligned huge page that has nothing
+ * mapped yet, that is mapped instead.  A region already mapped page
+ * by page stays that way: moving its contents to a huge frame would
+ * change the kernel addresses that futexes on it are keyed by. */
+bool
+process_heap_fault (void *fault_addr) {
+	struct thread *cur = thread_current ();
+	uintptr_t *start, *brk;
+	void *upage = pg_round_down (fault_addr);
+	void *hpage = hpg_round_down (fault_addr);
+	bool ok = false;
+
+	if (cur->pml4 == NULL)
+		return false;
+	heap_lock (cur, &start, &brk);
+	if ((uintptr_t) fault_addr >= *start && (uintptr_t) fault_addr < *brk) {
+		bool huge = (uintptr_t) hpage >= *start
+			&& (uintptr_t) hpage + HPGSIZE <= *brk;
+
+		/* Another thread may have mapped the page first. */
+		ok = pml4_get_page (cur->pml4, upage) != NULL;
+		if (!ok && huge)
+			ok = heap_map_huge (cur, hpage);
+		if (!ok) {
+			void *kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+			if (kpage != NULL) {
+				ok = pml4_set_page (cur->pml4, upage, kpage, true);
+				if (!ok)
+					palloc_free_page (kpage);
+			}
+		}
+	}
+	heap_unlock (cur);
+	return ok;
+}
+
 /* Switch the current execution context to the f_name.
  * Returns -1 on fail. */
 int
 process_exec (void *f_name) {
 	char *file_name = f_name;
 	bool success;
+	struct thread *cur = thread_current ();
+
+	/* The address space cannot be replaced under other threads. */
+	if (cur->group != NULL) {
+		bool alone;
+
+		lock_acquire (&cur->group->lock);
+		alone = cur->group->refs == 1 && !cur->group->exiting;
+		lock_release (&cur->group->lock);
+		if (!alone) {
+			palloc_free_page (file_name);
+			return -1;
+		}
+		thread_group_leave (cur);
+		/* From now on this is a process of its own, which its
+		 * parent waits for as such. */
+		cur->stack_slot = -1;
+	}
+	vfork_release (cur);
 
 	/* We cannot use the intr_frame in the thread structure.
 	 * This is because when current thread rescheduled,
@@ -222,6 +832,7 @@ process_exec (void *f_name) {
 
 	/* We first kill the current context */
 	process_cleanup ();
+	fpu_release (thread_current ());
 
 	/* And then load the binary */
 	success = load (file_name, &_if);
@@ -248,6 +859,23 @@ process_exec (void *f_name) {
  * does nothing. */
 int
 process_wait (tid_t child_tid) {
+	return wait_child (child_tid, false);
+}
+
+/* Waits for user thread TID, created by the current thread with
+ * process_create_thread(), to exit and returns its exit status.
+ * Returns -1 at once under the same conditions as
+ * process_wait(). */
+int
+process_join (tid_t tid) {
+	return wait_child (tid, true);
+}
+
+/* Waits for child CHILD_TID of the current thread to die and
+ * returns its exit status.  The child must be a user thread if
+ * USER_THREAD is true, a process otherwise. */
+static int
+wait_child (tid_t child_tid, bool user_thread) {
 	/* XXX: Hint) The pintos exit if process_wait (initd), we recommend you
 	 * XXX:       to add infinite loop here before
 	 * XXX:       implementing the process_wait. */
@@ -262,7 +890,7 @@ process_wait (tid_t child_tid) {
 			break;
 		}
 	}
-	if(child == NULL) return -1;
+	if(child == NULL || (child->stack_slot >= 0) != user_thread) return -1;
 
 	sema_down(&child->wait);
 	list_remove(&child->child_elem);
@@ -282,18 +910,36 @@ process_exit (void) {
 	 * TODO: We recommend you to implement process resource cleanup here. */
 
 
- 	for (int i = 2; i < 128; i++)
-        close(i);
-	// palloc_free_page(curr->fdt);
-	palloc_free_multiple(curr->fdt, 3);
+	/* Threads other than the last leave the shared address space
+	 * and descriptor table alone. */
+	if (curr->group != NULL && !thread_group_leave (curr)) {
+		curr->fdt = NULL;
+		curr->pml4 = NULL;
+		pml4_activate (NULL);
+	}
+
+	vfork_release (curr);
+	fd_table_destroy (curr->fdt);
+	curr->fdt = NULL;
 	
-	file_close(curr->exec_file);
+	/* Text pages are shared until the page table goes, and the
+	 * executable must stay unwritable until then. */
 	process_cleanup ();
+	file_close(curr->exec_file);
 
 	sema_up(&curr->wait);
 	sema_down(&curr->exit);
 }
 
+/* Drops the text cache's reference for PTE if it maps a shared
+ * page.  Passed to pml4_for_each(). */
+static bool
+put_shared_pte (uint64_t *pte, void *va UNUSED, void *aux UNUSED) {
+	if (is_user_pte (pte) && is_shared_pte (pte))
+		text_cache_put (ptov (PTE_ADDR (*pte)));
+	return true;
+}
+
 /* Free the current process's resources. */
 static void
 process_cleanup (void) {
@@ -317,6 +963,7 @@ process_cleanup (void) {
 		 * that's been freed (and cleared). */
 		curr->pml4 = NULL;
 		pml4_activate (NULL);
+		pml4_for_each (pml4, put_shared_pte, NULL);
 		pml4_destroy (pml4);
 	}
 }
@@ -401,6 +1048,7 @@ load (const char *file_name, struct intr_frame *if_) {
 	struct ELF ehdr;
 	struct file *file = NULL;
 	off_t file_ofs;
+	uint64_t image_end = 0;
 	bool success = false;
 	int i;
 
@@ -427,6 +1075,15 @@ load (const char *file_name, struct intr_frame *if_) {
 		goto done;
 	}
 
+	/* Project 2 */
+	/* Deny writes before any page of the executable is mapped, so
+	 * that none can change under the text cache.  The old image is
+	 * gone by now, so its executable may be written again. */
+	file_close (t->exec_file);
+	t->exec_file = file;
+	// 현재 실행중인 파일은 수정할 수 없게 막는다.
+	file_deny_write(file);
+
 	/* Read and verify executable header. */
 	if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
 			|| memcmp (ehdr.e_ident, "\177ELF\2\1\1", 7)
@@ -485,6 +1142,8 @@ load (const char *file_name, struct intr_frame *if_) {
 					if (!load_segment (file, file_page, (void *) mem_page,
 								read_bytes, zero_bytes, writable))
 						goto done;
+					if (phdr.p_vaddr + phdr.p_memsz > image_end)
+						image_end = phdr.p_vaddr + phdr.p_memsz;
 				}
 				else
 					goto done;
@@ -492,10 +1151,8 @@ load (const char *file_name, struct intr_frame *if_) {
 		}
 	}
 
-	/* Project 2 */
-	t->exec_file = file;
-	// 현재 실행중인 파일은 수정할 수 없게 막는다.
-	file_deny_write(file);
+	/* The heap starts empty just past the image. */
+	t->heap_start = t->heap_brk = ROUND_UP (image_end, PGSIZE);
 
 	/* Set up stack. */
 	if (!setup_stack (if_))
@@ -570,6 +1227,8 @@ validate_segment (const struct Phdr *phdr, struct file *file) {
 
 /* load() helpers. */
 static bool install_page (void *upage, void *kpage, bool writable);
+static bool install_text_page (struct file *, off_t ofs, void *upage,
+		size_t read_bytes);
 
 /* Loads a segment starting at offset OFS in FILE at address
  * UPAGE.  In total, READ_BYTES + ZERO_BYTES bytes of virtual
@@ -581,7 +1240,8 @@ static bool install_page (void *upage, void *kpage, bool writable);
  * - ZERO_BYTES bytes at UPAGE + READ_BYTES must be zeroed.
  *
  * The pages initialized by this function must be writable by the
- * user process if WRITABLE is true, read-only otherwise.
+ * user process if WRITABLE is true, read-only otherwise.  Read-only
+ * pages are shared with other processes through the text cache.
  *
  * Return true if successful, false if a memory allocation error
  * or disk read error occurs. */
@@ -600,26 +1260,30 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-		/* Get a page of memory. */
-		uint8_t *kpage = palloc_get_page (PAL_USER);
-		if (kpage == NULL)
-			return false;
-
-		/* Load this page. */
-		if (file_read (file, kpage, page_read_bytes) != (int) page_read_bytes) {
-			palloc_free_page (kpage);
+		if (writable) {
+			/* Get a page of memory. */
+			uint8_t *kpage = palloc_get_page (PAL_USER);
+			if (kpage == NULL)
+				return false;
+
+			/* Load this page. */
+			if (file_read (file, kpage, page_read_bytes) != (int) page_read_bytes) {
+				palloc_free_page (kpage);
+				return false;
+			}
+			memset (kpage + page_read_bytes, 0, page_zero_bytes);
+
+			/* Add the page to the process's address space. */
+			if (!install_page (upage, kpage, writable)) {
+				printf("fail\n");
+				palloc_free_page (kpage);
+				return false;
+			}
+		} else if (!install_text_page (file, ofs, upage, page_read_bytes))
 			return false;
-		}
-		memset (kpage + page_read_bytes, 0, page_zero_bytes);
-
-		/* Add the page to the process's address space. */
-		if (!install_page (upage, kpage, writable)) {
-			printf("fail\n");
-			palloc_free_page (kpage);
-			return false;
-		}
 
 		/* Advance. */
+		ofs += page_read_bytes;
 		read_bytes -= page_read_bytes;
 		zero_bytes -= page_zero_bytes;
 		upage += PGSIZE;
@@ -662,6 +1326,26 @@ install_page (void *upage, void *kpage, bool writable) {
 	return (pml4_get_page (t->pml4, upage) == NULL
 			&& pml4_set_page (t->pml4, upage, kpage, writable));
 }
+
+/* Maps a read-only page at UPAGE holding READ_BYTES bytes of FILE
+ * from offset OFS, then zeros.  The frame comes from the text
+ * cache, shared with other processes running the same executable.
+ * Returns true on success. */
+static bool
+install_text_page (struct file *file, off_t ofs, void *upage,
+		size_t read_bytes) {
+	struct thread *t = thread_current ();
+	void *kpage = text_cache_get (file, ofs, read_bytes);
+
+	if (kpage == NULL)
+		return false;
+	if (pml4_get_page (t->pml4, upage) != NULL
+			|| !pml4_set_shared_page (t->pml4, upage, kpage)) {
+		text_cache_put (kpage);
+		return false;
+	}
+	return true;
+}
 #else
 /* From here, codes will be used after project 3.
  * If you want to implement the function for only project 2, implement it on the
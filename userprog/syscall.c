@@ -1,6 +1,9 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <ring.h>
+#include <spawn.h>
 #include <syscall-nr.h>
+#include <uio.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/loader.h"
@@ -10,18 +13,24 @@
 
 
 /* Project 2 */
+#include "userprog/fdtable.h"
+#include "userprog/futex.h"
+#include "userprog/percpu.h"
 #include "userprog/process.h"
+#include "userprog/textcache.h"
+#include "userprog/uaccess.h"
+#include "filesys/directory.h"
 #include "filesys/filesys.h"
 #include "filesys/file.h"
+#include "filesys/pipe.h"
 #include "threads/synch.h"
 #include "threads/palloc.h"
+#include "threads/mmu.h"
+#include "threads/vaddr.h"
 
 void syscall_entry (void);
 void syscall_handler (struct intr_frame *);
 
-/* Project 2 */
-struct lock filesys_lock;
-
 /* System call.
  *
  * Previously system call services was handled by the interrupt handler
@@ -34,12 +43,47 @@ struct lock filesys_lock;
 #define MSR_STAR 0xc0000081         /* Segment selector msr */
 #define MSR_LSTAR 0xc0000082        /* Long mode SYSCALL target */
 #define MSR_SYSCALL_MASK 0xc0000084 /* Mask for the eflags */
+#define MSR_GS_BASE 0xc0000101      /* Current GS base */
+#define MSR_KERNEL_GS_BASE 0xc0000102 /* GS base that SWAPGS swaps in */
+
+/* Size of the on-stack buffer that small reads and writes bounce
+ * through.  Larger transfers bounce through a page at a time. */
+#define SMALL_IO_SIZE 128
+
+/* User memory is never touched directly: arguments are copied in
+ * and out with the fault-handled routines in userprog/uaccess.c,
+ * and a bad pointer kills the process. */
+
+/* Copies file name NAME from user memory into BUF, which must hold
+ * NAME_MAX + 2 bytes.  Returns false if NAME is too long to name a
+ * file. */
+static bool
+copy_in_name (char *buf, const char *name)
+{
+	int64_t len = strncpy_from_user(buf, name, NAME_MAX + 2);
+	if (len < 0) exit(-1);
+	return len <= NAME_MAX;
+}
 
-void check_address(void *addr)
+/* Returns a bounce buffer for a SIZE-byte transfer, either SMALL or
+ * a fresh page, and stores how much it holds in *CHUNK. */
+static void *
+bounce_get (size_t size, void *small, size_t *chunk)
 {
-	if(addr == NULL) exit(-1);
-	if(!is_user_vaddr(addr)) exit(-1);
-  if (pml4_get_page(thread_current()->pml4, addr) == NULL) exit(-1);
+	if (size <= SMALL_IO_SIZE) {
+		*chunk = SMALL_IO_SIZE;
+		return small;
+	}
+	*chunk = PGSIZE;
+	return palloc_get_page(0);
+}
+
+/* Releases bounce buffer BUF obtained from bounce_get(). */
+static void
+bounce_put (void *buf, void *small)
+{
+	if (buf != small)
+		palloc_free_page(buf);
 }
 
 
@@ -53,7 +97,12 @@ void exit(int status)
 {
     struct thread *curr = thread_current();
     curr->exit_status = status;
-    printf("%s: exit(%d)\n", curr->name, status);
+    /* A multithreaded process ends as a whole, and its initial
+     * thread prints the message once the others are gone. */
+    if (curr->group != NULL)
+        process_exit_group(status);
+    else
+        printf("%s: exit(%d)\n", curr->name, status);
 	
     thread_exit();
 }
@@ -68,12 +117,15 @@ int fork(const char *thread_name, struct intr_frame *f)
 int exec(const char *cmd_line)
 {
 
-	check_address(cmd_line);
 	char * cmd_line_copy;
 	cmd_line_copy = palloc_get_page(0);
 	if (cmd_line_copy == NULL)
 			exit(-1);
-	strlcpy(cmd_line_copy, cmd_line, PGSIZE);
+	if (strncpy_from_user(cmd_line_copy, cmd_line, PGSIZE) < 0) {
+		palloc_free_page(cmd_line_copy);
+		exit(-1);
+	}
+	cmd_line_copy[PGSIZE - 1] = '\0';
 
 	// 스레드의 이름을 변경하지 않고 바로 실행한다.
 	if (process_exec(cmd_line_copy) == -1)
@@ -89,139 +141,709 @@ int wait(int pid)
 // 5.
 bool create(const char *file, unsigned initial_size)
 {
-    check_address(file);
-    return filesys_create(file, initial_size);
+    char name[NAME_MAX + 2];
+    if (!copy_in_name(name, file)) return false;
+    return filesys_create(name, initial_size);
 }
 
 // 6.
 bool remove (const char *file) {
-	check_address(file);
-	return filesys_remove(file);
+	char name[NAME_MAX + 2];
+	if (!copy_in_name(name, file)) return false;
+	return filesys_remove(name);
 }
 
 // 7.
 int open (const char *file) {
-	check_address(file);
+	char name[NAME_MAX + 2];
+	if (!copy_in_name(name, file)) return -1;
 
 	int fd;
 	struct thread *cur = thread_current();
-	struct file *file_obj = filesys_open(file);
-	if(cur->name==NULL || file_obj == NULL) return -1;
-	
-	for(fd=2;fd<128,cur->fdt[fd]!=NULL;fd++) continue;
+	struct file *file_obj = filesys_open(name);
+	if(file_obj == NULL) return -1;
 
-	if(fd==128){
+	fd = fd_install(cur->fdt, file_obj);
+	if(fd == -1)
 		file_close(file_obj);
-		fd = -1;
-	}
-	else{
-		cur->fdt[fd] = file_obj;
-		cur->fd = fd;
-	}
 
 	return fd;
 }
 
 // 8.
 int filesize(int fd) {
-
-	if(	fd < 0 || fd >= 128) return -1;
-
 	struct thread * cur = thread_current();
-	struct file *fileobj = cur->fdt[fd];
+	struct file *fileobj = fd_get(cur->fdt, fd);
+	int length;
 	if (fileobj == NULL) return -1;
 
-	return file_length(fileobj);
+	length = file_length(fileobj);
+	fd_put(fileobj);
+	return length;
 }
 
 // 9.
 int read(int fd, void *buffer, unsigned size) {
 	// 유효한 주소인지부터 체크
-	unsigned char *buf = buffer;
-	int read_count;
-	check_address(buffer);
+	uint8_t small[SMALL_IO_SIZE];
+	uint8_t *kbuf;
+	size_t chunk;
+	unsigned read_count = 0;
+	bool eof = false;
+	if (!is_user_range(buffer, size)) exit(-1);
 
-	if(	fd < 0 || fd>=128) return -1;
-	
 	struct thread *cur = thread_current();
-	struct file *fileobj = cur->fdt[fd];
-	
-	if (fileobj == NULL) return -1;
-	
-	/* STDIN일 때: */
-	if (fd == 0) {
-		char key;
-		for (read_count = 0; read_count < size; read_count++) {
-			key  = input_getc();
-			*buf++ = key;
-			if (key == '\0') break;
-		}
-	}
+	struct file *fileobj = NULL;
+
 	/* STDOUT일 때: -1 반환 */
-	else if (fd == 1) return -1;
-	else {
-		lock_acquire(&filesys_lock);
-		read_count = file_read(fileobj, buffer, size);
-		lock_release(&filesys_lock);
+	if (fd == STDOUT_FILENO) return -1;
+	if (fd != STDIN_FILENO) {
+		fileobj = fd_get(cur->fdt, fd);
+		if (fileobj == NULL) return -1;
+	}
 
+	kbuf = bounce_get(size, small, &chunk);
+	if (kbuf == NULL) {
+		fd_put(fileobj);
+		return -1;
 	}
+	while (read_count < size && !eof) {
+		size_t n = size - read_count < chunk ? size - read_count : chunk;
+		size_t got;
+
+		/* STDIN일 때: */
+		if (fileobj == NULL) {
+			for (got = 0; got < n; got++) {
+				char key = input_getc();
+				kbuf[got] = key;
+				if (key == '\0') break;
+			}
+		}
+		else {
+			off_t r = file_read(fileobj, kbuf, n);
+			if (r < 0) {
+				bounce_put(kbuf, small);
+				fd_put(fileobj);
+				return read_count > 0 ? (int) read_count : -1;
+			}
+			got = r;
+		}
+		/* A pipe returns what has arrived rather than waiting
+		 * for more. */
+		eof = got < n || (fileobj != NULL && file_get_pipe(fileobj) != NULL);
+
+		if (!copy_to_user((uint8_t *) buffer + read_count, kbuf, got)) {
+			bounce_put(kbuf, small);
+			fd_put(fileobj);
+			exit(-1);
+		}
+		read_count += got;
+	}
+	bounce_put(kbuf, small);
+	fd_put(fileobj);
 	return read_count;
 }
 
 // 10.
 int write (int fd, const void *buffer, unsigned size) {
-	check_address(buffer);
-	// check_address(buffer + size);
+	uint8_t small[SMALL_IO_SIZE];
+	uint8_t *kbuf;
+	size_t chunk;
+	unsigned write_count = 0;
+	if (!is_user_range(buffer, size)) exit(-1);
 
-	if(	fd < 0 || fd >= 128) return -1;
 	struct thread *cur = thread_current();
-	struct file *fileobj = cur->fdt[fd];
-	if (fileobj == NULL) return -1;
+	struct file *fileobj = NULL;
+
+	if (fd == STDIN_FILENO) return -1;
+	if (fd != STDOUT_FILENO) {
+		fileobj = fd_get(cur->fdt, fd);
+		if (fileobj == NULL) return -1;
+	}
 
-	int write_count;
-	if (fd == 1) {
-		putbuf(buffer, size);
-		write_count = size;
+	kbuf = bounce_get(size, small, &chunk);
+	if (kbuf == NULL) {
+		fd_put(fileobj);
+		return -1;
 	}
-	else if (fd == 0) return -1;
-	else {
-		lock_acquire(&filesys_lock);
-		write_count = file_write(fileobj, buffer, size);
-		lock_release(&filesys_lock);
+	while (write_count < size) {
+		size_t n = size - write_count < chunk ? size - write_count : chunk;
+		size_t put;
+
+		if (!copy_from_user(kbuf, (const uint8_t *) buffer + write_count, n)) {
+			bounce_put(kbuf, small);
+			fd_put(fileobj);
+			exit(-1);
+		}
+		if (fileobj == NULL) {
+			putbuf((const char *) kbuf, n);
+			put = n;
+		}
+		else {
+			off_t r = file_write(fileobj, kbuf, n);
+			if (r < 0) {
+				bounce_put(kbuf, small);
+				fd_put(fileobj);
+				return write_count > 0 ? (int) write_count : -1;
+			}
+			put = r;
+		}
+		write_count += put;
+		if (put < n) break;
 	}
+	bounce_put(kbuf, small);
+	fd_put(fileobj);
 	return write_count;
 }
 // 11.
 void seek(int fd, unsigned position)
 {
-    if(	fd < 2 || fd >= 128) return;
-		struct thread *cur = thread_current();
-    struct file *file = cur->fdt[fd];
+    struct thread *cur = thread_current();
+    struct file *file = fd_get(cur->fdt, fd);
     if(file == NULL)
         return;
     file_seek(file, position);
+    fd_put(file);
 }
 // 12.
 unsigned tell(int fd)
 {
 
-		if(	fd < 2 || fd >= 128) return;
-		struct thread *cur = thread_current();
-    struct file *file = cur->fdt[fd];
+    struct thread *cur = thread_current();
+    struct file *file = fd_get(cur->fdt, fd);
+    unsigned position;
     if(file == NULL)
-        return;
-    return file_tell(file);
+        return -1;
+    position = file_tell(file);
+    fd_put(file);
+    return position;
 }
 
 // 13.
 void close(int fd)
 {
-		if(	fd < 2 || fd >= 128) return;
-		struct thread *cur = thread_current();
-    struct file *file = cur->fdt[fd];
-    if(file == NULL) return;
-    file_close(file);
-    cur->fdt[fd] = NULL;
+    struct thread *cur = thread_current();
+    file_close(fd_remove(cur->fdt, fd));
+}
+
+// 14.
+int pread(int fd, void *buffer, unsigned size, off_t offset)
+{
+	uint8_t small[SMALL_IO_SIZE];
+	uint8_t *kbuf;
+	size_t chunk;
+	unsigned read_count = 0;
+	if (!is_user_range(buffer, size)) exit(-1);
+
+	struct thread *cur = thread_current();
+	struct file *fileobj = fd_get(cur->fdt, fd);
+	if (fileobj == NULL || file_get_pipe(fileobj) != NULL || offset < 0
+			|| (kbuf = bounce_get(size, small, &chunk)) == NULL) {
+		fd_put(fileobj);
+		return -1;
+	}
+
+	while (read_count < size) {
+		size_t n = size - read_count < chunk ? size - read_count : chunk;
+		size_t got = file_read_at(fileobj, kbuf, n, offset + read_count);
+
+		if (!copy_to_user((uint8_t *) buffer + read_count, kbuf, got)) {
+			bounce_put(kbuf, small);
+			fd_put(fileobj);
+			exit(-1);
+		}
+		read_count += got;
+		if (got < n) break;
+	}
+	bounce_put(kbuf, small);
+	fd_put(fileobj);
+	return read_count;
+}
+
+// 15.
+int pwrite(int fd, const void *buffer, unsigned size, off_t offset)
+{
+	uint8_t small[SMALL_IO_SIZE];
+	uint8_t *kbuf;
+	size_t chunk;
+	unsigned write_count = 0;
+	if (!is_user_range(buffer, size)) exit(-1);
+
+	struct thread *cur = thread_current();
+	struct file *fileobj = fd_get(cur->fdt, fd);
+	if (fileobj == NULL || file_get_pipe(fileobj) != NULL || offset < 0
+			|| (kbuf = bounce_get(size, small, &chunk)) == NULL) {
+		fd_put(fileobj);
+		return -1;
+	}
+
+	while (write_count < size) {
+		size_t n = size - write_count < chunk ? size - write_count : chunk;
+		size_t put;
+
+		if (!copy_from_user(kbuf, (const uint8_t *) buffer + write_count, n)) {
+			bounce_put(kbuf, small);
+			fd_put(fileobj);
+			exit(-1);
+		}
+		put = file_write_at(fileobj, kbuf, n, offset + write_count);
+		write_count += put;
+		if (put < n) break;
+	}
+	bounce_put(kbuf, small);
+	fd_put(fileobj);
+	return write_count;
+}
+
+/* Position within a user iovec array. */
+struct iov_cursor {
+	const struct iovec *uiov;   /* User iovec array. */
+	int cnt;                    /* Number of iovecs. */
+	int idx;                    /* Index of current iovec. */
+	struct iovec cur;           /* Copy of current iovec. */
+	size_t ofs;                 /* Bytes of CUR already used. */
+};
+
+/* Loads iovec IDX of C's array.  Returns false if the array or
+ * the buffer it describes is not user memory. */
+static bool
+iov_load (struct iov_cursor *c, int idx)
+{
+	c->idx = idx;
+	c->ofs = 0;
+	if (idx < c->cnt)
+		return (copy_from_user(&c->cur, &c->uiov[idx], sizeof c->cur)
+				&& is_user_range(c->cur.iov_base, c->cur.iov_len));
+	c->cur.iov_len = 0;
+	return true;
+}
+
+/* Copies SIZE bytes between kernel buffer KBUF and the user
+ * buffers at cursor C, advancing C.  Copies into the user buffers
+ * if TO_USER is true, out of them otherwise.  Returns false if a
+ * user buffer is not accessible. */
+static bool
+iov_copy (struct iov_cursor *c, uint8_t *kbuf, size_t size, bool to_user)
+{
+	while (size > 0) {
+		size_t n = c->cur.iov_len - c->ofs;
+		uint8_t *ubuf = (uint8_t *) c->cur.iov_base + c->ofs;
+		bool ok;
+
+		if (n == 0) {
+			/* The buffers shrank since iov_total() saw them. */
+			if (c->idx >= c->cnt || !iov_load(c, c->idx + 1))
+				return false;
+			continue;
+		}
+		if (n > size)
+			n = size;
+		ok = to_user ? copy_to_user(ubuf, kbuf, n) : copy_from_user(kbuf, ubuf, n);
+		if (!ok) return false;
+		c->ofs += n;
+		kbuf += n;
+		size -= n;
+	}
+	return true;
+}
+
+/* Returns the total length of the IOVCNT buffers at user address
+ * IOV, or -1 if IOVCNT or the total is out of range.  Kills the
+ * process if the buffers are not user memory. */
+static int64_t
+iov_total (const struct iovec *iov, int iovcnt)
+{
+	struct iov_cursor c = { .uiov = iov, .cnt = iovcnt };
+	int64_t total = 0;
+	int i;
+
+	if (iovcnt < 0 || iovcnt > IOV_MAX) return -1;
+	for (i = 0; i < iovcnt; i++) {
+		if (!iov_load(&c, i)) exit(-1);
+		total += c.cur.iov_len;
+		if (total > INT32_MAX) return -1;
+	}
+	return total;
+}
+
+/* Moves bytes between FD and the IOVCNT user buffers in IOV.
+ * The buffers are gathered into, or scattered from, a kernel page,
+ * so each page of data costs one file system call however many
+ * buffers it spans. */
+static int
+vectored_io (int fd, const struct iovec *iov, int iovcnt, bool is_write)
+{
+	struct iov_cursor c = { .uiov = iov, .cnt = iovcnt };
+	int64_t total = iov_total(iov, iovcnt);
+	int64_t done = 0;
+	uint8_t *kbuf;
+
+	struct thread *cur = thread_current();
+	struct file *fileobj = fd_get(cur->fdt, fd);
+	bool console = is_write && fd == STDOUT_FILENO;
+	bool fault = false;
+	if (total < 0 || (fileobj == NULL && !console)
+			|| (kbuf = palloc_get_page(0)) == NULL) {
+		fd_put(fileobj);
+		return -1;
+	}
+
+	fault = !iov_load(&c, 0);
+	while (done < total && !fault) {
+		size_t n = total - done < PGSIZE ? total - done : PGSIZE;
+		off_t moved;
+
+		if (is_write) {
+			if (!iov_copy(&c, kbuf, n, false)) {
+				fault = true;
+				break;
+			}
+			if (console) {
+				putbuf((const char *) kbuf, n);
+				moved = n;
+			}
+			else
+				moved = file_write(fileobj, kbuf, n);
+		}
+		else {
+			moved = file_read(fileobj, kbuf, n);
+			if (moved > 0 && !iov_copy(&c, kbuf, moved, true)) {
+				fault = true;
+				break;
+			}
+		}
+		if (moved < 0) {
+			if (done == 0) done = -1;
+			break;
+		}
+		done += moved;
+		/* Like read(), stop at whatever one pipe read delivers. */
+		if ((size_t) moved < n || (!is_write && file_get_pipe(fileobj) != NULL))
+			break;
+	}
+	palloc_free_page(kbuf);
+	fd_put(fileobj);
+	if (fault) exit(-1);
+	return done;
+}
+
+// 16.
+int readv(int fd, const struct iovec *iov, int iovcnt)
+{
+	return vectored_io(fd, iov, iovcnt, false);
+}
+
+// 17.
+int writev(int fd, const struct iovec *iov, int iovcnt)
+{
+	return vectored_io(fd, iov, iovcnt, true);
+}
+
+// 18.
+/* Copies up to SIZE bytes from IN_FD's position to OUT_FD's
+ * position, advancing both, without the data passing through user
+ * memory.  Returns the number of bytes copied. */
+int copy_file_range(int in_fd, int out_fd, unsigned size)
+{
+	struct thread *cur = thread_current();
+	struct file *in = fd_get(cur->fdt, in_fd);
+	struct file *out = fd_get(cur->fdt, out_fd);
+	unsigned copied = 0;
+	uint8_t *kbuf = NULL;
+
+	if (in == NULL || out == NULL
+			|| file_get_pipe(in) != NULL || file_get_pipe(out) != NULL
+			|| (kbuf = palloc_get_page(0)) == NULL) {
+		fd_put(in);
+		fd_put(out);
+		return -1;
+	}
+
+	while (copied < size) {
+		off_t n = size - copied < PGSIZE ? size - copied : PGSIZE;
+		off_t got = file_read(in, kbuf, n);
+		off_t put = got > 0 ? file_write(out, kbuf, got) : 0;
+
+		copied += put;
+		if (put < got)
+			file_seek(in, file_tell(in) - (got - put));
+		if (got < n || put < got) break;
+	}
+	palloc_free_page(kbuf);
+	fd_put(in);
+	fd_put(out);
+	return copied;
+}
+
+/* User address at which ring_setup() maps a process's ring, well
+ * clear of the executable below and the stack above.  Keeping the
+ * ring at a fixed address leaves the kernel nothing to track: the
+ * ring is found through the page table, is copied by fork() like
+ * any other page, and is freed with the address space. */
+#define RING_BASE ((void *) (USER_STACK - 0x800000))
+
+// 19.
+/* Maps a ring with ENTRIES slots in each queue into the process
+ * and returns its user address, or NULL if ENTRIES is not a power
+ * of two between 1 and RING_MAX_ENTRIES or the process already has
+ * a ring. */
+void *ring_setup(unsigned entries)
+{
+	struct thread *cur = thread_current();
+	struct ring *r;
+
+	ASSERT(sizeof *r <= PGSIZE);
+	if (entries == 0 || entries > RING_MAX_ENTRIES || (entries & (entries - 1)))
+		return NULL;
+	if (pml4_get_page(cur->pml4, RING_BASE) != NULL)
+		return NULL;
+
+	r = palloc_get_page(PAL_USER | PAL_ZERO);
+	if (r == NULL) return NULL;
+	r->entries = entries;
+	if (!pml4_set_page(cur->pml4, RING_BASE, r, true)) {
+		palloc_free_page(r);
+		return NULL;
+	}
+	return RING_BASE;
+}
+
+/* Runs request SQE and returns its result. */
+static int
+ring_run (const struct ring_sqe *sqe)
+{
+	void *buf = (void *) sqe->addr;
+	struct file *file;
+
+	switch (sqe->opcode) {
+		case RING_OP_NOP:
+			return 0;
+		case RING_OP_READ:
+			return sqe->off < 0 ? read(sqe->fd, buf, sqe->len)
+			                    : pread(sqe->fd, buf, sqe->len, sqe->off);
+		case RING_OP_WRITE:
+			return sqe->off < 0 ? write(sqe->fd, buf, sqe->len)
+			                    : pwrite(sqe->fd, buf, sqe->len, sqe->off);
+		case RING_OP_OPEN:
+			return open(buf);
+		case RING_OP_CLOSE:
+			file = fd_remove(thread_current()->fdt, sqe->fd);
+			if (file == NULL) return -1;
+			file_close(file);
+			return 0;
+		case RING_OP_FSYNC:
+			/* Writes go straight to disk, so there is nothing to
+			 * flush. */
+			file = fd_get(thread_current()->fdt, sqe->fd);
+			fd_put(file);
+			return file != NULL ? 0 : -1;
+		default:
+			return -1;
+	}
+}
+
+// 20.
+/* Runs up to TO_SUBMIT requests queued in the process's ring,
+ * posting a completion for each, and returns the number run.  Stops
+ * early if the submission queue empties or the completion queue
+ * fills.  Requests run synchronously, so every request run has
+ * completed on return. */
+int ring_enter(unsigned to_submit)
+{
+	struct ring *r = pml4_get_page(thread_current()->pml4, RING_BASE);
+	unsigned entries, done = 0;
+
+	if (r == NULL) return -1;
+
+	/* The process can scribble on the ring at any time, so trust
+	 * nothing in it beyond what masking makes safe. */
+	entries = r->entries;
+	if (entries == 0 || entries > RING_MAX_ENTRIES || (entries & (entries - 1)))
+		return -1;
+
+	while (done < to_submit) {
+		uint32_t head = r->sq_head, tail = r->sq_tail;
+		uint32_t cq_tail = r->cq_tail;
+		struct ring_sqe sqe;
+		struct ring_cqe *cqe;
+
+		if (head == tail || cq_tail - r->cq_head >= entries)
+			break;
+		sqe = r->sq[head & (entries - 1)];
+		r->sq_head = head + 1;
+
+		cqe = &r->cq[cq_tail & (entries - 1)];
+		cqe->user_data = sqe.user_data;
+		cqe->res = ring_run(&sqe);
+		cqe->flags = 0;
+		r->cq_tail = cq_tail + 1;
+		done++;
+	}
+	return done;
+}
+
+// 21.
+/* Creates a pipe and stores descriptors for its read and write
+ * ends in FDS[0] and FDS[1].  Returns 0 if successful, -1 if
+ * memory or descriptors are exhausted. */
+int pipe(int *fds)
+{
+	struct thread *cur = thread_current();
+	struct file *rd, *wr;
+	int kfds[2];
+
+	if (!is_user_range(fds, sizeof kfds)) exit(-1);
+	if (!pipe_create(&rd, &wr)) return -1;
+	kfds[0] = fd_install(cur->fdt, rd);
+	kfds[1] = kfds[0] < 0 ? -1 : fd_install(cur->fdt, wr);
+	if (kfds[1] < 0) {
+		if (kfds[0] >= 0) fd_remove(cur->fdt, kfds[0]);
+		file_close(rd);
+		file_close(wr);
+		return -1;
+	}
+	if (!copy_to_user(fds, kfds, sizeof kfds)) exit(-1);
+	return 0;
+}
+
+// 22.
+/* Moves up to SIZE bytes between FD_IN and FD_OUT, exactly one of
+ * which must be a pipe, without the data passing through user
+ * memory or a bounce buffer: the file is read into, or written
+ * from, the pipe's own buffer.  Returns the number of bytes moved,
+ * 0 at end of file, or -1 on error. */
+int splice(int fd_in, int fd_out, unsigned size)
+{
+	struct thread *cur = thread_current();
+	struct file *in = fd_get(cur->fdt, fd_in);
+	struct file *out = fd_get(cur->fdt, fd_out);
+	int moved = -1;
+
+	if (in != NULL && out != NULL && size <= INT32_MAX)
+		moved = file_splice(in, out, size);
+	fd_put(in);
+	fd_put(out);
+	return moved;
+}
+
+// 23.
+/* Starts a thread in the current process at user address ENTRY,
+ * passing it ARG0 and ARG1. */
+int thread_create_user(void *entry, uint64_t arg0, uint64_t arg1)
+{
+	if (!is_user_vaddr(entry)) return TID_ERROR;
+	return process_create_thread(entry, arg0, arg1);
+}
+
+// 24.
+/* Ends the calling thread with STATUS, without the termination
+ * message that exit() prints for a process. */
+void thread_exit_user(int status)
+{
+	thread_current()->exit_status = status;
+	thread_exit();
+}
+
+// 25.
+/* Applies ACTION to FDT, a child's descriptor table being built by
+ * spawn().  Returns false if the action cannot be done. */
+static bool
+spawn_apply(struct fd_table *fdt, const struct spawn_action *action)
+{
+	char name[NAME_MAX + 2];
+	struct file *file, *src;
+
+	switch (action->op) {
+		case SPAWN_OPEN:
+			if (!copy_in_name(name, action->path)) return false;
+			file = filesys_open(name);
+			break;
+		case SPAWN_DUP2:
+			src = fd_get(fdt, action->src);
+			if (src == NULL) return false;
+			if (action->src == action->fd) {
+				fd_put(src);
+				return true;
+			}
+			file = file_duplicate(src);
+			fd_put(src);
+			break;
+		case SPAWN_CLOSE:
+			file_close(fd_remove(fdt, action->fd));
+			return true;
+		default:
+			return false;
+	}
+	if (file == NULL) return false;
+	if (!fd_install_at(fdt, action->fd, file)) {
+		file_close(file);
+		return false;
+	}
+	return true;
+}
+
+/* Starts the program in CMD_LINE in a new process, the way fork()
+ * followed by exec() would, but without copying the caller's
+ * memory.  The child gets a copy of the caller's descriptors
+ * changed by ACTION_CNT ACTIONS (see <spawn.h>).  Returns the new
+ * process's pid, or -1 if an action fails or the program cannot be
+ * loaded. */
+int spawn(const char *cmd_line, const struct spawn_action *actions, int action_cnt)
+{
+	struct spawn_action kactions[SPAWN_ACTIONS_MAX];
+	struct fd_table *fdt;
+	char *cmd_line_copy;
+	int i;
+
+	if (action_cnt < 0 || action_cnt > SPAWN_ACTIONS_MAX) return -1;
+	if (!copy_from_user(kactions, actions, action_cnt * sizeof *kactions))
+		exit(-1);
+
+	cmd_line_copy = palloc_get_page(0);
+	if (cmd_line_copy == NULL) return -1;
+	if (strncpy_from_user(cmd_line_copy, cmd_line, PGSIZE) < 0) {
+		palloc_free_page(cmd_line_copy);
+		exit(-1);
+	}
+	cmd_line_copy[PGSIZE - 1] = '\0';
+
+	fdt = fd_table_create();
+	if (fdt == NULL || !fd_table_copy(fdt, thread_current()->fdt))
+		goto error;
+	for (i = 0; i < action_cnt; i++)
+		if (!spawn_apply(fdt, &kactions[i]))
+			goto error;
+	return process_spawn(cmd_line_copy, fdt);
+
+error:
+	fd_table_destroy(fdt);
+	palloc_free_page(cmd_line_copy);
+	return -1;
+}
+
+// 26.
+int vfork(struct intr_frame *f)
+{
+	return process_vfork(f);
+}
+
+/* Returns the kernel address of the futex word at user address
+ * UADDR, which names the word's frame and offset.  Kills the
+ * process if UADDR is misaligned or not mapped. */
+static const int32_t *
+futex_key (int32_t *uaddr)
+{
+	const int32_t *key;
+	int32_t val;
+
+	/* Reading the word first faults it in if it is not yet
+	 * present. */
+	if ((uintptr_t) uaddr % sizeof *uaddr != 0
+			|| !copy_from_user(&val, uaddr, sizeof val))
+		exit(-1);
+	key = pml4_get_page(thread_current()->pml4, uaddr);
+	if (key == NULL) exit(-1);
+	return key;
 }
 
 void
@@ -235,7 +857,13 @@ syscall_init (void) {
 	 * mode stack. Therefore, we masked the FLAG_FL. */
 	write_msr(MSR_SYSCALL_MASK,
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
-	lock_init(&filesys_lock);
+
+	/* syscall_entry finds the per-CPU area by swapping it into GS. */
+	write_msr(MSR_GS_BASE, 0);
+	write_msr(MSR_KERNEL_GS_BASE, (uint64_t) &percpu);
+
+	futex_init();
+	text_cache_init ();
 }
 
 /* The main system call interface */
@@ -296,8 +924,63 @@ syscall_handler (struct intr_frame *f) {
 		case SYS_CLOSE:
 			close(f->R.rdi);
 			break;
+		case SYS_PREAD:
+			f->R.rax = pread(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10);
+			break;
+		case SYS_PWRITE:
+			f->R.rax = pwrite(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10);
+			break;
+		case SYS_READV:
+			f->R.rax = readv(f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_WRITEV:
+			f->R.rax = writev(f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_COPY_FILE_RANGE:
+			f->R.rax = copy_file_range(f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_PIPE:
+			f->R.rax = pipe(f->R.rdi);
+			break;
+		case SYS_SPLICE:
+			f->R.rax = splice(f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_RING_SETUP:
+			f->R.rax = (uint64_t) ring_setup(f->R.rdi);
+			break;
+		case SYS_RING_ENTER:
+			f->R.rax = ring_enter(f->R.rdi);
+			break;
+		case SYS_FUTEX_WAIT:
+			f->R.rax = futex_wait(futex_key((int32_t *) f->R.rdi), f->R.rsi);
+			break;
+		case SYS_FUTEX_WAKE:
+			f->R.rax = futex_wake(futex_key((int32_t *) f->R.rdi), f->R.rsi);
+			break;
+		case SYS_THREAD_CREATE:
+			f->R.rax = thread_create_user(f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_THREAD_JOIN:
+			f->R.rax = process_join(f->R.rdi);
+			break;
+		case SYS_THREAD_EXIT:
+			thread_exit_user(f->R.rdi);
+			break;
+		case SYS_SBRK:
+			f->R.rax = (uint64_t) process_sbrk(f->R.rdi);
+			break;
+		case SYS_SPAWN:
+			f->R.rax = spawn(f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_VFORK:
+			f->R.rax = vfork(f);
+			break;
 		default:
 			break;
 	}
 	// printf ("system call!\n");
+
+	/* Another thread may have ended the process meanwhile. */
+	if (thread_current()->killed)
+		thread_exit();
 }
@@ -2,5 +2,10 @@ userprog_SRC  = userprog/process.c	# Process loading.
 userprog_SRC += userprog/exception.c	# User exception handler.
 userprog_SRC += userprog/syscall-entry.S # System call entry.
 userprog_SRC += userprog/syscall.c	# System call handler.
+userprog_SRC += userprog/fdtable.c	# File descriptor tables.
+userprog_SRC += userprog/futex.c	# Futex wait queues.
+userprog_SRC += userprog/textcache.c	# Shared executable pages.
+userprog_SRC += userprog/uaccess.c	# User memory access.
+userprog_SRC += userprog/uaccess-entry.S # User memory access primitives.
 userprog_SRC += userprog/gdt.c		# GDT initialization.
 userprog_SRC += userprog/tss.c		# TSS management.
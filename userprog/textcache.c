@@ -0,0 +1,179 @@
+#include "userprog/textcache.h"
+#include <debug.h>
+#include <hash.h>
+#include <ohash.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Read-only executable pages shared between processes.
+ *
+ * A page of a read-only segment is the same in every process that
+ * runs the executable, so load() maps one frame for it into all of
+ * them instead of reading a private copy each time.  Pages are
+ * named by the inode and offset they are read from and by how many
+ * bytes of the page come from the file, and live only as long as
+ * some page table maps them.  Writes to the executable are denied
+ * for that whole time, so a cached page never goes stale. */
+struct text_page {
+	struct hash_elem key_elem;  /* In TEXT_PAGES. */
+	struct hash_elem frame_elem;/* In TEXT_FRAMES. */
+	struct inode *inode;        /* File the page is read from. */
+	off_t ofs;                  /* Offset in the file. */
+	size_t read_bytes;          /* Bytes read; the rest is zero. */
+	void *kpage;                /* The frame. */
+	int refs;                   /* Page tables mapping KPAGE. */
+};
+
+/* TEXT_LOCK guards both tables and every page's REFS. */
+static struct hash text_pages;  /* By INODE, OFS and READ_BYTES. */
+static struct ohash text_frames;/* By KPAGE. */
+static struct lock text_lock;
+
+static void inspect_frames (struct intr_frame *);
+
+static uint64_t
+text_page_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct text_page *p = hash_entry (e, struct text_page, key_elem);
+	return hash_ptr (p->inode) ^ hash_int (p->ofs);
+}
+
+static bool
+text_page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct text_page *a = hash_entry (a_, struct text_page, key_elem);
+	const struct text_page *b = hash_entry (b_, struct text_page, key_elem);
+
+	if (a->inode != b->inode)
+		return a->inode < b->inode;
+	if (a->ofs != b->ofs)
+		return a->ofs < b->ofs;
+	return a->read_bytes < b->read_bytes;
+}
+
+static uint64_t
+text_frame_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct text_page *p = hash_entry (e, struct text_page, frame_elem);
+	return hash_ptr (p->kpage);
+}
+
+static bool
+text_frame_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct text_page, frame_elem)->kpage
+		< hash_entry (b, struct text_page, frame_elem)->kpage;
+}
+
+/* Initializes the text page cache. */
+void
+text_cache_init (void) {
+	if (!hash_init (&text_pages, text_page_hash, text_page_less, NULL)
+			|| !ohash_init (&text_frames, text_frame_hash, text_frame_less, NULL))
+		PANIC ("text page cache creation failed");
+	lock_init (&text_lock);
+	intr_register_int (0x46, 3, INTR_OFF, inspect_frames,
+			"Inspect User Frames");
+}
+
+/* Returns a frame holding READ_BYTES bytes of FILE from offset
+ * OFS followed by zeros, shared with every other caller asking for
+ * the same, or a null pointer if out of memory or the read fails.
+ * Release it with text_cache_put(). */
+void *
+text_cache_get (struct file *file, off_t ofs, size_t read_bytes) {
+	struct text_page key, *p;
+	struct hash_elem *e;
+
+	ASSERT (read_bytes <= PGSIZE);
+
+	key.inode = file_get_inode (file);
+	key.ofs = ofs;
+	key.read_bytes = read_bytes;
+
+	lock_acquire (&text_lock);
+	e = hash_find (&text_pages, &key.key_elem);
+	if (e != NULL) {
+		p = hash_entry (e, struct text_page, key_elem);
+		p->refs++;
+		lock_release (&text_lock);
+		return p->kpage;
+	}
+
+	/* Reading under the lock keeps two loaders of the same page
+	 * from both reading it. */
+	p = malloc (sizeof *p);
+	if (p == NULL)
+		goto fail;
+	*p = key;
+	p->refs = 1;
+	p->kpage = palloc_get_page (PAL_USER);
+	if (p->kpage == NULL)
+		goto fail;
+	if (file_read_at (file, p->kpage, read_bytes, ofs) != (off_t) read_bytes) {
+		palloc_free_page (p->kpage);
+		goto fail;
+	}
+	memset ((uint8_t *) p->kpage + read_bytes, 0, PGSIZE - read_bytes);
+	hash_insert (&text_pages, &p->key_elem);
+	if (ohash_insert (&text_frames, &p->frame_elem) != NULL) {
+		hash_delete (&text_pages, &p->key_elem);
+		palloc_free_page (p->kpage);
+		goto fail;
+	}
+	lock_release (&text_lock);
+	return p->kpage;
+
+fail:
+	lock_release (&text_lock);
+	free (p);
+	return NULL;
+}
+
+/* Returns the cached page whose frame is KPAGE. */
+static struct text_page *
+text_cache_lookup (void *kpage) {
+	struct text_page key;
+	struct hash_elem *e;
+
+	key.kpage = kpage;
+	e = ohash_find (&text_frames, &key.frame_elem);
+	ASSERT (e != NULL);
+	return hash_entry (e, struct text_page, frame_elem);
+}
+
+/* Takes another reference to KPAGE, which text_cache_get()
+ * returned, for a new page table mapping it. */
+void
+text_cache_dup (void *kpage) {
+	lock_acquire (&text_lock);
+	text_cache_lookup (kpage)->refs++;
+	lock_release (&text_lock);
+}
+
+/* Drops a reference to KPAGE, freeing it with the last one. */
+void
+text_cache_put (void *kpage) {
+	struct text_page *p;
+
+	lock_acquire (&text_lock);
+	p = text_cache_lookup (kpage);
+	if (--p->refs == 0) {
+		hash_delete (&text_pages, &p->key_elem);
+		ohash_delete (&text_frames, &p->frame_elem);
+		palloc_free_page (p->kpage);
+		free (p);
+	}
+	lock_release (&text_lock);
+}
+
+/* Tool for benchmarking user programs. Calling this function via int 0x46.
+ * Output:
+ *   @RAX - Number of frames in use in the user pool. */
+static void
+inspect_frames (struct intr_frame *f) {
+	f->R.rax = palloc_used_cnt (PAL_USER);
+}
@@ -2,6 +2,7 @@
 #include <debug.h>
 #include <stddef.h>
 #include "userprog/gdt.h"
+#include "userprog/percpu.h"
 #include "threads/thread.h"
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
@@ -48,6 +49,10 @@
 /* Kernel TSS. */
 struct task_state *tss;
 
+/* This CPU's per-CPU area.  tss_update() keeps its kernel stack
+ * pointer in step with the TSS's. */
+struct percpu percpu;
+
 /* Initializes the kernel TSS. */
 void
 tss_init (void) {
@@ -55,6 +60,9 @@ tss_init (void) {
 	 * few fields of it are ever referenced, and those are the only
 	 * ones we initialize. */
 	tss = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+	ASSERT (offsetof (struct percpu, kernel_rsp) == PERCPU_KERNEL_RSP);
+	ASSERT (offsetof (struct percpu, user_rsp) == PERCPU_USER_RSP);
+	ASSERT (offsetof (struct percpu, curr) == PERCPU_CURR);
 	tss_update (thread_current ());
 }
 
@@ -65,10 +73,12 @@ tss_get (void) {
 	return tss;
 }
 
-/* Sets the ring 0 stack pointer in the TSS to point to the end
- * of the thread stack. */
+/* Sets the ring 0 stack pointer in the TSS and the per-CPU area
+ * to point to the end of the thread stack. */
 void
 tss_update (struct thread *next) {
 	ASSERT (tss != NULL);
 	tss->rsp0 = (uint64_t) next + PGSIZE;
+	percpu.kernel_rsp = tss->rsp0;
+	percpu.curr = next;
 }
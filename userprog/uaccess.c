@@ -0,0 +1,75 @@
+#include "userprog/uaccess.h"
+#include <debug.h>
+#include "threads/interrupt.h"
+#include "threads/vaddr.h"
+
+/* One exception table entry: if the instruction at INSN faults on
+ * a user address, execution resumes at FIXUP. */
+struct extable_entry {
+	uintptr_t insn;
+	uintptr_t fixup;
+};
+
+/* Defined in uaccess-entry.S. */
+size_t uaccess_copy (void *dst, const void *src, size_t size);
+int64_t uaccess_strncpy (char *dst, const char *src, size_t size);
+extern const struct extable_entry uaccess_extable[], uaccess_extable_end[];
+
+/* Returns true if SIZE bytes starting at UADDR all lie below
+ * KERN_BASE.  They may still be unmapped. */
+bool
+is_user_range (const void *uaddr, size_t size) {
+	uintptr_t start = (uintptr_t) uaddr;
+	return (size <= KERN_BASE && is_user_vaddr (uaddr)
+			&& start <= KERN_BASE - size);
+}
+
+/* Copies SIZE bytes from user address USRC to kernel buffer DST.
+ * Returns false if any part of the source is not readable user
+ * memory. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size) {
+	return is_user_range (usrc, size) && uaccess_copy (dst, usrc, size) == 0;
+}
+
+/* Copies SIZE bytes from kernel buffer SRC to user address UDST.
+ * Returns false if any part of the destination is not writable
+ * user memory. */
+bool
+copy_to_user (void *udst, const void *src, size_t size) {
+	return is_user_range (udst, size) && uaccess_copy (udst, src, size) == 0;
+}
+
+/* Copies the null-terminated string at user address USRC into
+ * DST, copying at most SIZE bytes.  Returns the length of the
+ * string, SIZE if it does not end within SIZE bytes (in which
+ * case DST is not null-terminated), or -1 if it is not readable
+ * user memory. */
+int64_t
+strncpy_from_user (char *dst, const char *usrc, size_t size) {
+	uintptr_t limit;
+
+	if (!is_user_vaddr (usrc))
+		return -1;
+	limit = KERN_BASE - (uintptr_t) usrc;
+	if (size > limit) {
+		int64_t len = uaccess_strncpy (dst, usrc, limit);
+		return len == (int64_t) limit ? -1 : len;
+	}
+	return uaccess_strncpy (dst, usrc, size);
+}
+
+/* Called by the page fault handler for a fault taken in kernel
+ * mode.  If the faulting instruction is a user access routine,
+ * redirects F to resume at its fixup and returns true. */
+bool
+uaccess_fixup (struct intr_frame *f) {
+	const struct extable_entry *e;
+
+	for (e = uaccess_extable; e < uaccess_extable_end; e++)
+		if (e->insn == f->rip) {
+			f->rip = e->fixup;
+			return true;
+		}
+	return false;
+}